@@ -0,0 +1,125 @@
+#ifndef DATASET_H
+#define DATASET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Formato binário versionado para configurações e resultados em lote.
+//
+// Layout (little endian): a DatasetHeader padded to DATASET_HEADER_BYTES, then recordCount
+// fixed-size records. The header count is only updated after the records it covers are on
+// disk, so a reader never sees a partially written record.
+const uint32_t DATASET_MAGIC = 0x53445050;  // "PPDS"
+const uint32_t DATASET_VERSION = 1;
+const size_t DATASET_HEADER_BYTES = 4096;   // one page, so records start page aligned
+
+enum DatasetKind : uint32_t {
+    DATASET_CONFIGURATIONS = 1,
+    DATASET_RESULTS = 2,
+};
+
+struct DatasetHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t kind;
+    uint32_t recordBytes;
+    uint64_t recordCount;
+    double circleRadius;    // disk radius the coordinates refer to
+};
+
+// x1 x2 x3 on the first line, y1 y2 y3 on the second, disk coordinates relative to the center
+struct ConfigurationRecord {
+    double points[6][2];
+};
+
+// flags of a ResultRecord
+const uint32_t RESULT_DEGENERATE = 1; // two intersections coincide, the axis is not determined
+
+struct ResultRecord {
+    double intersections[3][3]; // on the sphere, upper hemisphere
+    double axis[3];             // unit normal of the Pappus line
+    double residual;            // largest |axis . intersection| over the unit intersections
+    uint32_t flags;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(ConfigurationRecord) == 96, "configuration record layout changed");
+static_assert(sizeof(ResultRecord) == 112, "result record layout changed");
+
+// the record struct readers cast the mapping to; 0 for an unknown kind
+inline size_t datasetRecordBytes(uint32_t kind) {
+    switch(kind) {
+        case DATASET_CONFIGURATIONS: return sizeof(ConfigurationRecord);
+        case DATASET_RESULTS: return sizeof(ResultRecord);
+        default: return 0;
+    }
+}
+
+// Read-only mmap view of the records of a dataset, optionally restricted to a byte range
+// of the file so independent processes can each take one shard.
+class DatasetReader {
+public:
+    DatasetReader() = default;
+    ~DatasetReader();
+
+    DatasetReader(const DatasetReader&) = delete;
+    DatasetReader& operator=(const DatasetReader&) = delete;
+
+    // maps the records whose first byte lies in [byteBegin, byteEnd); false with error() set on failure,
+    // also when the record size is not the one of the kind or the file is shorter than the header count
+    bool open(const std::string& path, uint32_t expectedKind, uint64_t byteBegin = 0, uint64_t byteEnd = UINT64_MAX);
+    void close();
+
+    const DatasetHeader& header() const { return fileHeader; }
+    // records of the mapped range and the index of the first one in the whole file
+    size_t size() const { return count; }
+    size_t firstIndex() const { return first; }
+
+    template <typename T>
+    const T* records() const { return static_cast<const T*>(data); }
+
+    const std::string& error() const { return lastError; }
+
+private:
+    DatasetHeader fileHeader = {};
+    void* mapping = nullptr;
+    size_t mappingBytes = 0;
+    const void* data = nullptr;
+    size_t count = 0;
+    size_t first = 0;
+    std::string lastError;
+};
+
+// Appends fixed-size records through a page-aligned staging chunk written with large pwrite calls.
+class DatasetWriter {
+public:
+    DatasetWriter() = default;
+    ~DatasetWriter();
+
+    DatasetWriter(const DatasetWriter&) = delete;
+    DatasetWriter& operator=(const DatasetWriter&) = delete;
+
+    // creates (or truncates) the file; with append set an existing dataset of the same kind is continued
+    bool open(const std::string& path, uint32_t kind, uint32_t recordBytes, bool append = false);
+    bool append(const void* records, size_t recordCount);
+    // flushes the staged records and publishes the final count in the header
+    bool close();
+
+    size_t size() const { return written + staged; }
+    const std::string& error() const { return lastError; }
+
+private:
+    bool flushChunk();
+    bool writeHeader();
+
+    int fd = -1;
+    DatasetHeader fileHeader = {};
+    char* chunk = nullptr;
+    size_t chunkRecords = 0;  // capacity of the staging chunk in records
+    size_t staged = 0;
+    uint64_t written = 0;
+    std::string lastError;
+};
+
+#endif // DATASET_H
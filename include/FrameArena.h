@@ -0,0 +1,38 @@
+#ifndef FRAMEARENA_H
+#define FRAMEARENA_H
+
+#include <cstddef>
+#include <vector>
+
+// Bump allocator for data that lives for one frame. reset() releases everything at once;
+// when a frame spilled into extra blocks they are merged, so steady-state frames allocate nothing.
+class FrameArena {
+public:
+    FrameArena() = default;
+    ~FrameArena();
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    template <typename T>
+    T* allocate(size_t count) {
+        return static_cast<T*>(allocateBytes(count * sizeof(T), alignof(T)));
+    }
+    void* allocateBytes(size_t bytes, size_t alignment);
+
+    void reset();
+
+    size_t capacity() const;
+    size_t used() const;
+
+private:
+    struct Block {
+        char* data;
+        size_t size;
+    };
+    std::vector<Block> blocks;
+    size_t offset = 0;            // bump position in the last block
+    size_t usedInFullBlocks = 0;
+};
+
+#endif // FRAMEARENA_H
@@ -0,0 +1,136 @@
+#ifndef FRAMEGEOMETRY_H
+#define FRAMEGEOMETRY_H
+
+#include <cstdint>
+#include <tuple>
+#include <vector>
+#include "Vector3.h"
+#include "Matrix3.h"
+#include "GreatCircle.h"
+#include "TaskPool.h"
+#include "FrameArena.h"
+#include "conics.h"
+#include "camera.h"
+#include "utils.h"
+
+// primitive of a strip or batch; the values are the GL ones, so the GL backend and the draw
+// stream pass them through unchanged
+enum PrimitiveMode : uint32_t {
+    PRIMITIVE_POINTS = 0x0000,
+    PRIMITIVE_LINES = 0x0001,
+    PRIMITIVE_LINE_LOOP = 0x0002,
+    PRIMITIVE_LINE_STRIP = 0x0003,
+};
+
+// a run of packed vertices drawn with one primitive mode and one color, in submission order;
+// positions are origin + (x, y) * extent / QUANTIZATION_MAX. The origin stays in double:
+// it is made camera-relative at submission
+struct DrawRange {
+    PrimitiveMode mode;
+    PackedVertex* data; // points into the frame arena
+    size_t count;       // in vertices
+    double originX, originY;
+    float extent;
+    float color[3];
+};
+
+// consecutive ranges sharing mode, origin, extent and color, drawn with a single indexed call
+struct DrawBatch {
+    PrimitiveMode mode;
+    size_t firstIndex;
+    size_t indexCount;
+    double originX, originY;
+    float extent;
+    float color[3];
+};
+
+// a curve is stored relative to its own center (the disk center for projected lines) with a
+// little headroom over the radius, unless that grid is coarser than the pixel at the current
+// zoom; then each visible run gets its own origin and extent
+const float RING_EXTENT_RADII = 1.125f;
+// a coarser grid than pixel / CURVE_GRID_PER_PIXEL switches a curve to per-run origins
+const double CURVE_GRID_PER_PIXEL = 16.0;
+// visible runs are refined until a piece spans at most this many pixels
+const double CULL_PIECE_PIXELS = 256.0;
+// cap on a single strip, reached only by absurd steps
+const size_t MAX_RUN_VERTICES = 1 << 20;
+
+// separates strips inside one batch
+const uint32_t PRIMITIVE_RESTART_INDEX = 0xFFFFFFFF;
+
+// Vertex data of one frame: strips filled right away plus projected lines tessellated
+// on a task pool into preassigned slices. All vertex staging is carved out of a frame arena
+// with exact-size reservations and released at once by clear().
+class FrameGeometry {
+public:
+    FrameArena arena;
+    std::vector<DrawRange> ranges;
+    // produced by build(): strips of a batch joined by restart markers
+    uint32_t* indices = nullptr;
+    size_t indexCount = 0;
+    std::vector<DrawBatch> batches;
+    // analytic mode sends curves to conics instead of tessellating them
+    bool analyticConics = false;
+    ConicSet conics;
+    // quality of the frame: angular step on a disk-sized curve at zoom 1, and whether antipodal copies are drawn
+    double tessellationStep = TESSELLATION_STEP;
+    bool drawExtras = true;
+    // curves are culled against this view and tessellated for its zoom
+    ViewTransform view;
+
+    void clear();
+
+    // reserve a range the caller fills immediately; the pointer is valid until clear()
+    PackedVertex* appendStrip(size_t vertexCount, PrimitiveMode mode, double originX, double originY, float extent, Vector3 color);
+
+    // circle around a world point; only its visible runs are tessellated, by build()
+    void appendRing(double centerX, double centerY, double radius, Vector3 color);
+
+    // round dots at points given relative to a disk of the given radius; off-screen ones are dropped
+    void appendPoints(const std::tuple<double, double>* points, size_t count, double offsetX, double offsetY,
+                      double radius, Vector3 color);
+
+    // circle around (centerX, centerY) on the disk centered at (offsetX, offsetY): a conic in
+    // analytic mode while the disk has room, otherwise a ring
+    void addCircle(double offsetX, double offsetY, double centerX, double centerY, double radius, Vector3 color);
+
+    // great circle through two sphere points: a conic in analytic mode while the disk has room,
+    // otherwise tessellated later by build()
+    void addProjectedLine(const Vector3& p1, const Vector3& p2, float offsetX, float offsetY, float radius, Vector3 color, bool arcOnly = false);
+
+    // tessellate every queued curve concurrently, then index the strips into batches
+    void build(TaskPool& pool);
+
+    // issue the draws in the order they were added, to the active render backend
+    void submit() const;
+
+    size_t vertexCount() const;
+
+private:
+    // center + a cos t + b sin t in world units, t in [t0, t1); radius sets the quantization grid
+    struct Curve {
+        double centerX, centerY;
+        double ax, ay, bx, by;
+        double t0, t1;
+        double radius;
+    };
+    // visible parameter interval and the world box around it
+    struct VisibleRun {
+        double t0, t1;
+        double minX, minY, maxX, maxY;
+    };
+    // one visible run of a curve, written into ranges[range] at the given angular step
+    struct CurveJob {
+        Curve curve;
+        double t0, step;
+        size_t range;
+    };
+    std::vector<CurveJob> jobs;
+    // visible parameter intervals of the curve being queued, reused across curves
+    std::vector<VisibleRun> runs;
+
+    void queueCurve(const Curve& curve, Vector3 color);
+    void findVisibleRuns(const Curve& curve, double speed, double t0, double t1, int depth);
+};
+
+#endif // FRAMEGEOMETRY_H
@@ -0,0 +1,41 @@
+#ifndef GREATCIRCLE_H
+#define GREATCIRCLE_H
+
+#include "Vector3.h"
+#include "Matrix3.h"
+
+// Projective line as a great circle of the sphere, built from its plane normal.
+// The orthonormal basis is computed once: u is the line's point at infinity (z = 0),
+// v completes the upper half circle and n is the normal flipped to z >= 0, so the
+// line is u cos t + v sin t for t in [0, PI] and its projection on the disk is the
+// ellipse with axes u.xy and v.xy.
+class GreatCircle {
+public:
+    GreatCircle();
+    explicit GreatCircle(const Vector3& normal);
+
+    // line through two points of the sphere (any radius)
+    static GreatCircle through(const Vector3& p1, const Vector3& p2);
+
+    const Vector3& u() const { return basisU; }
+    const Vector3& v() const { return basisV; }
+    const Vector3& normal() const { return basisN; }
+
+    // columns u, v, n: maps the unit circle of the xy plane onto this great circle
+    const Matrix3& transformation() const { return basis; }
+
+    // height of v; near zero the line is close to the ideal line and its
+    // projection needs the opposite half as well
+    double tilt() const { return basisV[2]; }
+    bool needsOppositeHalf() const { return tilt() <= 0.001; }
+
+    // point of the line, on the sphere of the given radius, closest to the disk position (x, y)
+    // along the projected ellipse; positions beyond the ends snap to the point at infinity
+    Vector3 project(double x, double y, double radius) const;
+
+private:
+    Vector3 basisU, basisV, basisN;
+    Matrix3 basis;
+};
+
+#endif // GREATCIRCLE_H
@@ -0,0 +1,51 @@
+#ifndef TASKPOOL_H
+#define TASKPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Pool of worker threads running indexed jobs; the calling thread helps while it waits
+class TaskPool {
+public:
+    explicit TaskPool(unsigned threadCount = std::thread::hardware_concurrency());
+    ~TaskPool();
+
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    // run job(0) .. job(count - 1) and return once all of them finished
+    void parallelFor(size_t count, const std::function<void(size_t)>& job);
+
+    // number of threads taking part in parallelFor, caller included
+    unsigned size() const;
+
+    static TaskPool& shared();
+
+private:
+    struct Batch {
+        const std::function<void(size_t)>* job;
+        size_t count;
+        std::atomic<size_t> next;
+        std::atomic<size_t> pending;
+    };
+
+    void workerLoop();
+    void runBatch(Batch& batch);
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::mutex submitMutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    Batch* current = nullptr;
+    unsigned activeWorkers = 0;
+    unsigned long generation = 0;
+    bool stopping = false;
+};
+
+#endif // TASKPOOL_H
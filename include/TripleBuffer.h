@@ -0,0 +1,42 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <atomic>
+
+// Lock-free single producer / single consumer exchange of the latest value.
+// The writer fills back() and publishes it, the reader picks up the newest published
+// slot with update(); neither side ever waits for the other.
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() : state(1), backIndex(0), frontIndex(2) {}
+
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    // writer side
+    T& back() { return slots[backIndex]; }
+    void publish() {
+        backIndex = state.exchange(backIndex | FRESH_BIT, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    // reader side: true when a newer slot than the current front was taken
+    bool update() {
+        if((state.load(std::memory_order_acquire) & FRESH_BIT) == 0) return false;
+        frontIndex = state.exchange(frontIndex, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+    bool hasUpdate() const { return (state.load(std::memory_order_acquire) & FRESH_BIT) != 0; }
+    const T& front() const { return slots[frontIndex]; }
+
+private:
+    static const unsigned FRESH_BIT = 4;
+    static const unsigned INDEX_MASK = 3;
+
+    T slots[3];
+    std::atomic<unsigned> state; // index of the middle slot plus FRESH_BIT
+    unsigned backIndex;          // owned by the writer
+    unsigned frontIndex;         // owned by the reader
+};
+
+#endif // TRIPLEBUFFER_H
@@ -0,0 +1,12 @@
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+#include <cstdint>
+
+// Number of global operator new calls since start, from every thread
+uint64_t heapAllocationCount();
+
+// when set, the compute and render stages print their per-frame allocation counts
+extern bool showAllocationStats;
+
+#endif // ALLOCATION_COUNTER_H
@@ -0,0 +1,43 @@
+#ifndef ANTIALIASING_H
+#define ANTIALIASING_H
+
+#include <GL/glew.h>
+
+// Suavização selecionável em tempo de execução, com custo medido por modo
+enum AntialiasingMode {
+    AA_LINE_SMOOTH,  // GL_LINE_SMOOTH per primitive, quality depends on the driver
+    AA_MSAA,         // offscreen multisample framebuffer resolved into the window
+    AA_FXAA,         // offscreen texture filtered by one full-screen FXAA pass
+    AA_NONE,
+    AA_MODE_COUNT
+};
+extern AntialiasingMode antialiasingMode;
+// measuring waits for the GPU at the end of a frame, so it only runs for this many frames
+// after every switch with key A; normal frames never wait
+const int AA_MEASURE_FRAMES = 120;
+// frames still to be measured; capture clears it
+extern int antialiasingMeasureFrames;
+
+void initAntialiasingResources();
+
+const char* antialiasingModeName(AntialiasingMode mode);
+// accepts the names above ("smooth", "msaa", "fxaa", "none"); false if unknown
+bool parseAntialiasingMode(const char* name);
+
+// switch to the next mode, measure it for AA_MEASURE_FRAMES frames and print the frame time
+// measured for every mode so far
+void cycleAntialiasingMode();
+
+// bind and clear the render target of the current mode; every draw of the frame goes in between
+void beginAntialiasedFrame();
+// an intermediate layer drawn with the current mode and resolved into framebuffer, which
+// must be single-sampled; FXAA is left to the final pass so the layer is not filtered twice
+void beginAntialiasedLayer(GLuint framebuffer);
+void endAntialiasedLayer(GLuint framebuffer);
+// rebind the target of the frame in progress after a layer, without clearing it
+void resumeAntialiasedFrame();
+
+// resolve or filter into the window framebuffer, then (while measuring) wait for the GPU and record the frame time
+void endAntialiasedFrame();
+
+#endif // ANTIALIASING_H
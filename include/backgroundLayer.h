@@ -0,0 +1,19 @@
+#ifndef BACKGROUND_LAYER_H
+#define BACKGROUND_LAYER_H
+
+#include <cstdint>
+
+// Camada de fundo guardada numa textura do tamanho da janela, refeita só quando muda
+void initBackgroundLayer();
+
+// true unless the texture holds the layer with this key at the current window size and anti-aliasing mode
+bool backgroundLayerStale(uint64_t key);
+
+// the background geometry is drawn between these two; the frame target is bound again afterwards
+void beginBackgroundLayer();
+void endBackgroundLayer(uint64_t key);
+
+// copy the cached layer over the whole frame target; replaces the clear color
+void compositeBackgroundLayer();
+
+#endif // BACKGROUND_LAYER_H
@@ -0,0 +1,51 @@
+#ifndef CAMERA_H
+#define CAMERA_H
+
+// Câmera 2D: zoom e deslocamento da vista sobre o mundo
+const double MIN_CAMERA_ZOOM = 0.25;
+const double MAX_CAMERA_ZOOM = 1e6;
+// step of one wheel notch and of the + / - keys outside the gallery
+const double CAMERA_ZOOM_STEP = 1.25;
+
+struct Camera {
+    double centerX = 0.0, centerY = 0.0;
+    double zoom = 1.0;
+};
+
+// world -> clip for one camera and window size: clip = (world - center) * scale.
+// Kept in double; only camera-relative offsets, small at any zoom, reach the GPU as floats
+struct ViewTransform {
+    double centerX = 0.0, centerY = 0.0;
+    double scaleX = 1.0, scaleY = 1.0;
+    double zoom = 1.0;
+    // world units covered by one pixel
+    double pixelSize = 1.0;
+
+    double halfWidth() const { return 1.0 / scaleX; }
+    double halfHeight() const { return 1.0 / scaleY; }
+    // true if the box reaches into the visible rectangle grown by margin on every side
+    bool overlaps(double minX, double minY, double maxX, double maxY, double margin = 0.0) const;
+    // column-major mat3 for positions already relative to the center
+    void relativeMatrix(float m[9]) const;
+    // column-major mat3 for absolute world positions, for data that never leaves the home view
+    void worldMatrix(float m[9]) const;
+};
+
+// GLUT thread; copied into every published input
+extern Camera camera;
+
+// at zoom 1 the world rectangle (WORLD_LEFT..WORLD_RIGHT, WORLD_BOTTOM..WORLD_TOP) fits the window
+ViewTransform viewTransform(const Camera& camera, int width, int height);
+// the live camera over the current window
+ViewTransform currentView();
+
+// inverse of the view for a window pixel (origin top left)
+void screenToWorld(const ViewTransform& view, int mouseX, int mouseY, int width, int height, double& worldX, double& worldY);
+
+// zoom by factor keeping the world point under the pixel fixed
+void zoomCameraAt(int mouseX, int mouseY, double factor);
+// move the view by a number of pixels
+void panCamera(int dx, int dy);
+void resetCamera();
+
+#endif // CAMERA_H
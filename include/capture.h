@@ -0,0 +1,37 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <cstdint>
+#include <cstdio>
+
+// Gravação de quadros: leitura assíncrona por PBOs e codificação numa thread à parte.
+// The readback of frame N is collected while frame N + 2 is being drawn, so the GPU is
+// never waited on. Whatever framebuffer is bound is read, so the offscreen sweep below goes
+// through the same ring and encoder as the window.
+
+// path ending in .y4m writes one uncompressed 4:4:4 stream, anything else is a prefix
+// for a PNG sequence (prefix_000000.png, ...). The size is fixed by the current window
+bool startCapture(const char* path);
+// collects the frames still in flight, waits for the encoder and prints the statistics
+void stopCapture();
+bool capturing();
+
+// R key: start or stop recording to the default path
+void toggleCapture();
+
+// queue the readback of the frame just resolved into the window. inputSequence is the
+// scene the frame shows; during a sweep only the frame of the newest sweep step is kept
+void captureFrame(uint64_t inputSequence);
+
+// move the interactive point along the first line in the given number of steps,
+// one captured frame each; capture stops at the end of the sweep
+const int CAPTURE_SWEEP_STEPS = 240;
+void startCaptureSweep(int steps);
+
+// --capture-offscreen <path> [width height]: one compute server record from the input
+// (see computeServer.h), its interactive point swept along the first line in
+// CAPTURE_SWEEP_STEPS frames drawn into a framebuffer object and captured to path. Needs a
+// current GL context and initGLResources; main keeps its window hidden. Returns the exit code
+int runOffscreenCapture(FILE* in, const char* path, int width, int height);
+
+#endif // CAPTURE_H
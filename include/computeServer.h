@@ -0,0 +1,33 @@
+#ifndef COMPUTE_SERVER_H
+#define COMPUTE_SERVER_H
+
+#include <cstdio>
+
+// Modo sem janela: um registro por linha na entrada, um resultado por linha na saída.
+//
+// record: x1 y1 x2 y2 x3 y3 u1 v1 u2 v2 u3 v3 [qx qy]...
+//   the two point triples and optional query points on the first line, all relative to
+//   the disk center (radius circleRadius); blank lines and lines starting with # are skipped
+// result, in input order:
+//   i1x i1y i2x i2y i3x i3y ax ay az [px py]...
+//   the three intersections and the image of each query point as disk coordinates on the
+//   upper hemisphere, the Pappus line as a unit normal; "error <reason>" for malformed records
+//
+// Input is read in large blocks, parsed and computed by the task pool a window of blocks at a
+// time, and written back in order, so memory stays bounded whatever the stream length.
+// Returns the process exit code.
+int runComputeServer(FILE* in, FILE* out);
+
+// same records on the input, stored as a configuration dataset (query points are dropped);
+// only error lines are written to stdout
+int runDatasetPack(FILE* in, const char* configurationPath);
+
+// results for the configurations in shard `shard` of `shardCount` byte ranges of the input
+// dataset, read through mmap and appended to a result dataset (see Dataset.h)
+int runDatasetCompute(const char* configurationPath, const char* resultPath, int shard, int shardCount);
+
+// --serve, --pack <dataset>, --compute <in> <out> [shard/count] and --render <png> [width height]
+// (cpuRasterizer.h); -1 when argv names none of them. Links without GL, see tools/pappusHeadless.cpp
+int runHeadlessCommand(int argc, char** argv);
+
+#endif // COMPUTE_SERVER_H
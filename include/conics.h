@@ -0,0 +1,60 @@
+#ifndef CONICS_H
+#define CONICS_H
+
+#include "Vector3.h"
+#include "Matrix3.h"
+#include "GreatCircle.h"
+#include "camera.h"
+
+// Renderização analítica: um quad por disco, curvas avaliadas por fragmento
+const int MAX_CONICS_PER_DISK = 64;
+const int MAX_CONIC_DISKS = 4;
+extern bool useAnalyticConics;
+
+// std140 layout: three vec4 arrays, one entry per conic
+struct ConicBlock {
+    float axes[MAX_CONICS_PER_DISK][4];        // A columns (a00, a10, a01, a11)
+    float centerFlags[MAX_CONICS_PER_DISK][4]; // center x, y, full ellipse flag, unused
+    float colors[MAX_CONICS_PER_DISK][4];
+};
+
+struct ConicDisk {
+    float offsetX, offsetY;
+    int count;
+    ConicBlock block;
+};
+
+// Conics of one frame grouped by the disk they are drawn on
+class ConicSet {
+public:
+    ConicDisk disks[MAX_CONIC_DISKS];
+    int diskCount = 0;
+    // curves that did not fit since the last clear and were tessellated instead
+    int dropped = 0;
+
+    void clear();
+
+    // queue the ellipse center + A*(cos t, sin t) on the disk centered at (offsetX, offsetY);
+    // A is given by its columns in world units, only t in [0, PI] is drawn unless fullEllipse.
+    // These return false, and queue nothing, once the disk holds MAX_CONICS_PER_DISK conics
+    bool addConic(float offsetX, float offsetY, float centerX, float centerY,
+                  float a00, float a10, float a01, float a11,
+                  Vector3 color, bool fullEllipse);
+
+    // same arc tessellateProjectedLine produces: the ellipse with axes u.xy and v.xy
+    bool addProjectedLine(const GreatCircle& line, float offsetX, float offsetY, float radius, bool drawOpposite, Vector3 color);
+
+    // circle of the given radius centered at (centerX, centerY) relative to the disk
+    bool addCircle(float offsetX, float offsetY, float centerX, float centerY, float radius, Vector3 color);
+
+private:
+    ConicDisk* findDisk(float offsetX, float offsetY);
+};
+
+// compile the conic program and create its uniform buffer
+void initConicResources();
+
+// draw one bounding quad per visible disk that received conics
+void drawConics(const ConicSet& conics, const ViewTransform& view);
+
+#endif // CONICS_H
@@ -0,0 +1,22 @@
+#ifndef CORRESPONDENCE_MAP_H
+#define CORRESPONDENCE_MAP_H
+
+#include <cstddef>
+#include "pappus.h"
+
+// Avaliação em lote da correspondência de Pappus (reta 1 -> reta 2).
+// Points are (x, y) on the first disk relative to its center and are lifted with
+// liftToSphere; images are (x, y, z) on the sphere of radius circleRadius, z >= 0.
+
+// reference: pappusImage in double precision for every point, spread over the task pool
+void mapPointsCpu(const PappusConfiguration& config, const float* points, size_t count, float* images);
+
+// GL 3.3 transform feedback: one vertex per point, rasterization discarded, results
+// captured into a buffer and read back; needs a current context, no compute shaders
+void mapPointsGpu(const PappusConfiguration& config, const float* points, size_t count, float* images);
+
+// --map-bench N: N points along the first line of a fixed configuration through both
+// paths, prints throughput and the largest deviation of the GPU from the reference
+void runCorrespondenceBenchmark(size_t count);
+
+#endif // CORRESPONDENCE_MAP_H
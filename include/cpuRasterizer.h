@@ -0,0 +1,78 @@
+#ifndef CPU_RASTERIZER_H
+#define CPU_RASTERIZER_H
+
+#include <cstdio>
+#include <cstdint>
+#include <vector>
+#include "renderBackend.h"
+#include "TaskPool.h"
+
+// Rasterizador em CPU: linhas e pontos suavizados num framebuffer em memória, sem chamadas GL.
+// Draws are only recorded; finish() bins the primitives into RASTER_TILE_SIZE tiles and
+// rasterizes the tiles on the task pool, four pixels per step, keeping the submission order
+// inside every tile. Lines are 1 pixel wide and points 6 pixels across, as in the GL shader;
+// coverage is blended like GL_LINE_SMOOTH. Triangles are not supported and are skipped.
+const int RASTER_TILE_SIZE = 64;
+
+// time spent in the last finish(), and what it went through
+struct RasterStats {
+    size_t primitives = 0;
+    size_t binEntries = 0;
+    double binMs = 0.0;
+    double rasterMs = 0.0;
+};
+
+class CpuRasterizer : public RenderBackend {
+public:
+    CpuRasterizer(int width, int height, TaskPool& pool = TaskPool::shared());
+
+    void clear(float r, float g, float b);
+
+    void drawVertices(const float* data, size_t floatCount, PrimitiveMode mode, const ViewTransform& view) override;
+    void drawIndexedRanges(const ViewTransform& view, const DrawRange* ranges, size_t rangeCount,
+                           const uint32_t* indices, size_t indexCount, const DrawBatch* batches, size_t batchCount) override;
+    const char* name() const override { return "cpu"; }
+
+    // rasterize everything recorded since the previous finish
+    void finish();
+
+    // RGBA8, bottom row first like glReadPixels
+    const unsigned char* pixels() const { return framebuffer.data(); }
+    int width() const { return targetWidth; }
+    int height() const { return targetHeight; }
+    const RasterStats& lastStats() const { return stats; }
+
+private:
+    // capsule around a segment in window pixels; a point is a segment of length zero
+    struct Primitive {
+        float x0, y0, x1, y1;
+        float halfWidth;
+        float color[3];
+    };
+
+    void addSegment(float x0, float y0, float x1, float y1, float halfWidth, const float color[3]);
+    void binChunk(size_t chunk, size_t first, size_t last);
+    void rasterTile(size_t tile);
+
+    TaskPool& pool;
+    int targetWidth, targetHeight;
+    int tilesX, tilesY;
+    std::vector<unsigned char> framebuffer;
+    std::vector<Primitive> primitives;
+    // the packed ranges of one drawIndexedRanges call, back to back
+    std::vector<PackedVertex> vertices;
+    // bins[chunk * tileCount + tile]: primitives of one chunk touching the tile, in order
+    std::vector<std::vector<uint32_t>> bins;
+    size_t chunkCount = 0;
+    RasterStats stats;
+};
+
+// --render <path> [width height]: one compute server record from the input (see computeServer.h),
+// drawn by the CPU rasterizer and written as a PNG; links without GL (tools/pappusHeadless.cpp)
+int runHeadlessRender(FILE* in, const char* path, int width, int height);
+
+// --raster-bench N (rasterBenchmark.cpp, GL): a fixed scene drawn N times by the GL driver into an offscreen target and
+// N times by the CPU rasterizer; prints the time per frame and how far the two images differ
+void runRasterBenchmark(size_t frames);
+
+#endif // CPU_RASTERIZER_H
@@ -0,0 +1,53 @@
+#ifndef DRAW_STREAM_H
+#define DRAW_STREAM_H
+
+#include <cstdint>
+
+// Gravação do fluxo de desenho: o que cada quadro envia pelos caminhos de vértices, num arquivo
+// binário que tools/replayDrawStream.cpp reenvia a um contexto fora da tela, sem a construção.
+//
+// file: DrawStreamHeader, then records, each starting with a uint32_t DrawStreamRecord:
+//   DRAW_STREAM_FRAME     uint32_t frame number; the draws up to the next one form that frame
+//   DRAW_STREAM_VERTICES  uint32_t mode, float view[9], float origin[2], uint32_t floatCount,
+//                         floatCount floats of interleaved x,y,r,g,b
+//   DRAW_STREAM_PACKED    float view[9], uint32_t vertexCount, indexCount, batchCount,
+//                         vertexCount int16_t x,y pairs, indexCount uint32_t (restart markers
+//                         included), batchCount DrawStreamBatch
+// Uniforms are stored as the GL backend sets them: view is the column-major uView, origins are
+// already relative to the camera. Everything is in host byte order.
+const uint32_t DRAW_STREAM_MAGIC = 0x31534450; // "PDS1"
+const uint32_t DRAW_STREAM_VERSION = 1;
+const uint32_t DRAW_STREAM_RESTART_INDEX = 0xFFFFFFFF;
+
+struct DrawStreamHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t width, height; // of the window the stream was recorded in
+};
+
+enum DrawStreamRecord : uint32_t {
+    DRAW_STREAM_FRAME = 1,
+    DRAW_STREAM_VERTICES = 2,
+    DRAW_STREAM_PACKED = 3
+};
+
+// one glDrawElements of a packed record
+struct DrawStreamBatch {
+    uint32_t mode;
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    float origin[2];
+    float positionScale;
+    float color[3];
+};
+
+// key D: start or stop writing the stream to the default path
+void toggleDrawStream();
+bool startDrawStream(const char* path);
+void stopDrawStream();
+bool recordingDrawStream();
+
+// called at the start of every displayed frame
+void markDrawStreamFrame();
+
+#endif // DRAW_STREAM_H
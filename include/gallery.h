@@ -0,0 +1,30 @@
+#ifndef GALLERY_H
+#define GALLERY_H
+
+#include <GL/glew.h>
+#include <cstddef>
+
+// Modo galeria: N construções independentes em grade, desenhadas por instâncias
+const int MAX_GALLERY_CONSTRUCTIONS = 1024;
+extern bool galleryMode;
+
+// compile the instanced program and create its buffers
+void initGalleryResources();
+
+// number of constructions laid out in the grid; changing it regenerates the instance data
+void setGallerySize(int count);
+int gallerySize();
+
+// points for the first constructions, one per line: x1 y1 x2 y2 x3 y3 y1x y1y y2x y2y y3x y3y
+// relative to the disk center; the remaining constructions get random points. false if unreadable
+bool loadGalleryPoints(const char* path);
+
+// two instanced draws (arcs and rings) whatever the size; only a sweep waits for the GPU to time them
+void drawGallery();
+// HUD text of the last gallery frame: N, submission time, instances
+void formatGalleryHud(char* hud, size_t size);
+
+// render every size from 1 to MAX_GALLERY_CONSTRUCTIONS and print frame time against N
+void startGallerySweep();
+
+#endif // GALLERY_H
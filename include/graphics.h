@@ -8,6 +8,10 @@
 
 #include <GL/glew.h>
 #include <vector>
+#include "FrameGeometry.h"
+#include "pipeline.h"
+#include "renderBackend.h"
+#include "scene.h"
 
 // Inicialização do OpenGL
 void myInit(void);
@@ -16,19 +20,38 @@ void myInit(void);
 extern GLuint shaderProgram;
 void initGLResources();
 
-// helper to draw interleaved vertex (x,y,r,g,b) data with a given primitive
-void drawVertices(const std::vector<float>& data, GLenum mode);
+// compile/link helpers shared by every shader program
+GLuint compileShader(GLenum type, const char* src);
+GLuint buildProgram(const char* vsSrc, const char* fsSrc);
+
+// helper to draw interleaved vertex (x,y,r,g,b) data with a given primitive, in the current view;
+// this and drawIndexedRanges go to the active render backend (renderBackend.h)
+void drawVertices(const std::vector<float>& data, PrimitiveMode mode);
+void drawVertices(const float* data, size_t floatCount, PrimitiveMode mode);
+
+// text quads of interleaved (x,y,r,g,b,u,v) floats, camera-relative, covered by the glyph atlas
+void drawGlyphQuads(const float* data, size_t floatCount, const ViewTransform& view, GLuint atlas);
+
+// upload the ranges back to back and issue one indexed draw per batch;
+// indices refer to that concatenation and PRIMITIVE_RESTART_INDEX separates strips
+void drawIndexedRanges(const ViewTransform& view, const DrawRange* ranges, size_t rangeCount,
+                       const uint32_t* indices, size_t indexCount, const DrawBatch* batches, size_t batchCount);
 
 // Callbacks do mouse
 void mouseClickCallback(int button, int state, int mouseX, int mouseY);
 void passiveMouseMotion(int x, int y);
+// motion with a button held: the right button pans the camera
+void mouseDragCallback(int x, int y);
+
+// Pontos extras nas retas (N >= 3 por reta, eixo por mínimos quadrados)
+// key E: clicks add the point under the mouse to the line of the nearer disk
+void toggleExtraPointMode();
+// key N: doubles the points per line with pairs taken from the current correspondence
+void generateExtraPoints();
 
 // Função principal de desenho
 void display(void);
 
-// Cálculo da rotação em Z, sua direção e X
-std::tuple<double, bool, double> calculateRotations(std::tuple<Vector3, Vector3> line);
-
 // Desenho de curvas de Bézier
 void draw_bezier_curve(Vector3 p0, Vector3 p1, Vector3 p2, Vector3 p3, int offsetX, int offsetY);
 
@@ -0,0 +1,17 @@
+#ifndef HEMISPHERE_VIEW_H
+#define HEMISPHERE_VIEW_H
+
+// Vista 3D do hemisfério numa segunda janela, girada com o mouse.
+// The window is created on the main GL context, so it uses the same program, buffers and vertex
+// arrays. It draws the packed vertex data of the scene the main window just showed, with no
+// retessellation: the vertex shader lifts every disk position onto the sphere and rotates it.
+// Curves culled by the main camera are missing here too, and analytic conics are not shown.
+const int HEMISPHERE_WINDOW_SIZE = 600;
+
+// key V: open the window, or hide / show it again
+void toggleHemisphereView();
+
+// after every frame of the main window: draws the same scene in the 3D view when it is open
+void postHemisphereRedisplay();
+
+#endif // HEMISPHERE_VIEW_H
@@ -0,0 +1,90 @@
+#ifndef ITERATED_PAPPUS_H
+#define ITERATED_PAPPUS_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "Vector3.h"
+#include "camera.h"
+
+// Construção de Pappus iterada: retas ligando pares de pontos e pontos cruzando pares de retas,
+// rodada após rodada, a partir dos seis pontos marcados.
+//
+// Round r joins every new point of round r - 1 with every earlier point, then meets every new
+// line with every earlier line (new ones of this round included); round 1 starts from the six
+// points alone, so it yields the two base lines, the nine cross-joins and their intersections.
+// Points and lines are unit homogeneous vectors equal up to sign, compared like
+// checkLinePointsDifferent: two vectors are the same element when min(|a - b|, |a + b|) is
+// within ITERATED_PAPPUS_TOLERANCE.
+const int ITERATED_PAPPUS_ROUNDS = 2;
+const double ITERATED_PAPPUS_TOLERANCE = 1e-9;
+// |a x b| of unit vectors below this is the same element twice, or too ill-conditioned to keep
+const double ITERATED_PAPPUS_MIN_SINE = 1e-7;
+// a round that would test more pairs stops the iteration; bounds the memory of a round as well
+const double ITERATED_PAPPUS_MAX_PAIRS = 1e7;
+// instances drawn of each kind, in creation order
+const size_t ITERATED_PAPPUS_MAX_DRAWN = 1 << 16;
+
+// rounds run by key I; --iterate-rounds K
+extern int iteratedPappusRounds;
+
+// Set of projective elements hashed on a grid of cell 2 * tolerance over the unit vector; a
+// lookup visits the few cells within tolerance of v and of -v, so the sign never matters
+class ProjectiveSet {
+public:
+    static const uint32_t NOT_FOUND = UINT32_MAX;
+
+    explicit ProjectiveSet(double tolerance = ITERATED_PAPPUS_TOLERANCE) : tolerance(tolerance) {}
+
+    // unit vectors only
+    uint32_t find(const Vector3& unit) const;
+    // false when an equal element is already there
+    bool insert(const Vector3& unit, uint8_t round);
+
+    size_t size() const { return elements.size(); }
+    const Vector3& operator[](size_t i) const { return elements[i]; }
+    uint8_t roundOf(size_t i) const { return rounds[i]; }
+    void clear();
+
+private:
+    uint64_t cellKey(long cx, long cy, long cz) const;
+    long cellOf(double v) const;
+    uint32_t findSigned(const Vector3& unit) const;
+
+    double tolerance;
+    // first element of every cell, then a chain through next
+    std::unordered_map<uint64_t, uint32_t> heads;
+    std::vector<uint32_t> next;
+    std::vector<Vector3> elements;
+    std::vector<uint8_t> rounds;
+};
+
+struct IteratedRound {
+    size_t linePairs = 0, pointPairs = 0; // pairs tested
+    size_t newLines = 0, newPoints = 0;
+    size_t lines = 0, points = 0;         // totals after the round
+    double generateMs = 0.0;              // parallel cross products and lookups
+    double mergeMs = 0.0;                 // serial insertion of the survivors
+};
+
+struct IteratedPappus {
+    ProjectiveSet points, lines;
+    std::vector<IteratedRound> rounds;
+    bool truncated = false; // stopped at ITERATED_PAPPUS_MAX_PAIRS before the last round
+};
+
+// the six points lifted to the sphere (any radius), run for the given number of rounds on the
+// shared task pool; prints one line per round when verbose
+void iteratePappus(const Vector3 x[3], const Vector3 y[3], int roundCount, IteratedPappus& result, bool verbose);
+
+// ---- Instanced drawing of the last result on both disks ----
+
+void initIteratedPappusResources();
+
+// key I: iterate from the current six points, or hide the result
+void toggleIteratedPappus();
+
+// one instanced draw for the lines and one for the points; nothing once the points changed
+void drawIteratedPappus(const ViewTransform& view);
+
+#endif // ITERATED_PAPPUS_H
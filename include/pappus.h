@@ -0,0 +1,46 @@
+#ifndef PAPPUS_H
+#define PAPPUS_H
+
+#include "Vector3.h"
+
+// Configuração de Pappus: dois ternos de pontos na esfera, retas como círculos máximos
+struct PappusConfiguration {
+    Vector3 x[3], y[3];
+    Vector3 intersections[3]; // x1y2.x2y1, x1y3.x3y1, x2y3.y2x3
+    Vector3 chosen1, chosen2; // two distinct intersections spanning the Pappus line
+    Vector3 axis;             // the Pappus line itself
+};
+
+// pure math shared by the interactive scene and the batch modes, no GL involved
+PappusConfiguration computePappus(const Vector3 x[3], const Vector3 y[3]);
+
+// image of a point of the first line on the second one: the line from center1 through the
+// point meets the Pappus line at axisPoint, the line from center2 through axisPoint meets
+// the second line at image; both results are put on the upper hemisphere
+struct PappusImage {
+    Vector3 center1, center2; // y1 and x1, or y2 and x2 when both are at infinity
+    Vector3 axisPoint;
+    Vector3 image;
+};
+PappusImage pappusImage(const PappusConfiguration& config, const Vector3& point);
+
+// largest |axis . intersection| over the unit intersections: zero up to rounding when the
+// triples are collinear, so it measures how far a configuration is from Pappus' hypothesis
+double pappusResidual(const PappusConfiguration& config);
+
+// Least-squares axis for N >= 3 points on each line: every pair i < j contributes the cross-join
+// x_i y_j . x_j y_i, N (N - 1) / 2 intersections in all (collinear only when the pairs x_i -> y_i
+// come from one projectivity, e.g. N = 3). Each intersection is weighted by the squared sine of
+// the angle between its two lines, so near-degenerate joins barely count
+struct AxisFit {
+    Vector3 axis;                 // unit normal of the fitted line, z >= 0
+    size_t pointsPerLine = 0;
+    size_t intersectionCount = 0;
+    double rmsResidual = 0.0;     // weighted RMS of |axis . intersection| over unit intersections
+    double maxResidual = 0.0;     // largest |axis . intersection| among well-conditioned joins
+    double ms = 0.0;
+};
+// rows of the batch run on the shared task pool
+AxisFit fitPappusAxis(const Vector3* x, const Vector3* y, size_t n);
+
+#endif // PAPPUS_H
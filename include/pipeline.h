@@ -0,0 +1,70 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <cstdint>
+#include <tuple>
+#include "FrameGeometry.h"
+#include "camera.h"
+#include "textOverlay.h"
+
+// Copy of the input globals the compute stage needs to build one frame
+struct InputState {
+    std::tuple<double, double, int, int> markedPoints[6];
+    int collectedPoints = 0;
+    int drawablePoints = 0;
+    std::tuple<double, double> interactivePoint;
+    bool canDrawInteractivePoint = false;
+    // only the first extraPointCount entries of each line are copied
+    std::tuple<double, double> extraPoints[2][MAX_EXTRA_POINTS];
+    int extraPointCount[2] = {};
+    uint64_t extraPointsVersion = 0;
+    std::tuple<double, double> extraCandidate;
+    int extraCandidateLine = -1;
+    bool showSupportingLines = false;
+    bool analyticConics = false;
+    // chosen by the quality scheduler
+    int qualityLevel = 0;
+    double tessellationStep = TESSELLATION_STEP;
+    bool drawExtras = true;
+    // view the frame is culled and tessellated for
+    Camera camera;
+    int viewWidth = INITIAL_WINDOW_WIDTH;
+    int viewHeight = INITIAL_WINDOW_HEIGHT;
+    uint64_t sequence = 0;
+};
+
+// Immutable scene handed from the compute stage to the render stage
+struct SceneSnapshot {
+    // the background is rebuilt only when its key changes
+    FrameGeometry background;
+    uint64_t backgroundKey = 0;
+    // the Pappus line drawn in the background, for snapping; it changes only with the background
+    bool hasAxis = false;
+    Vector3 axis;
+    FrameGeometry geometry;
+    TextLabel labels[MAX_SCENE_LABELS];
+    int labelCount = 0;
+    // interactive point and its image in disk coordinates, for the trail
+    bool hasCorrespondence = false;
+    double correspondence[4] = {};
+    uint64_t inputSequence = 0;
+    int qualityLevel = 0;
+    double buildMs = 0.0;
+    // heap allocations counted while building, zero once the arena has warmed up
+    uint64_t buildAllocations = 0;
+};
+
+// spawn the compute stage; it is stopped automatically at exit
+void startScenePipeline();
+
+// input stage (GLUT thread): snapshot the input globals and wake the compute stage
+void publishInput();
+// sequence number of the last published input
+uint64_t latestInputSequence();
+
+// render stage (GLUT thread): newest finished scene, empty until the first one is built
+const SceneSnapshot& acquireLatestScene();
+// the scene the last acquire returned, for further views of the same frame
+const SceneSnapshot& currentScene();
+
+#endif // PIPELINE_H
@@ -0,0 +1,9 @@
+#ifndef PNG_WRITER_H
+#define PNG_WRITER_H
+
+// PNG sem dependência de compressão: blocos deflate armazenados, sem GL.
+
+// one RGBA8 image, bottom row first as read back from GL, as an uncompressed PNG
+bool writePng(const char* path, const unsigned char* rgba, int width, int height);
+
+#endif // PNG_WRITER_H
@@ -0,0 +1,25 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include <GL/glew.h>
+
+// Cache em disco de programas já ligados (glGetProgramBinary/glProgramBinary),
+// indexado pelo driver e pelo hash das fontes
+
+// false disables both lookups and stores, for cold-start measurements
+extern bool useProgramCache;
+
+// linked program restored from the cache, or 0 when missing, stale or unsupported
+GLuint loadCachedProgram(const char* vsSrc, const char* fsSrc);
+
+// save a program linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set
+void storeCachedProgram(GLuint program, const char* vsSrc, const char* fsSrc);
+
+// true when the driver exposes at least one program binary format
+bool programBinarySupported();
+
+// lookups that hit and programs that had to be compiled since start
+extern int programCacheHits;
+extern int programCacheMisses;
+
+#endif // PROGRAM_CACHE_H
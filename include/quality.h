@@ -0,0 +1,34 @@
+#ifndef QUALITY_H
+#define QUALITY_H
+
+#include <vector>
+#include "pipeline.h"
+
+// Qualidade progressiva: geometria grossa durante o movimento, refinada quando ocioso
+struct QualitySettings {
+    // tessellation steps from coarse to fine, the last one is the full quality
+    std::vector<double> levels = {0.02, 0.005, TESSELLATION_STEP};
+    // while moving, the finest level measured to fit this budget is used
+    double frameBudgetMs = 16.0;
+    // time without motion events before refinement starts
+    double settleMs = 80.0;
+};
+extern QualitySettings qualitySettings;
+extern bool progressiveQuality;
+
+// parse "--quality-levels 0.02,0.005,0.001" and "--frame-budget 16"; false on malformed values
+bool parseQualityOption(const char* option, const char* value);
+
+// input stage: a passiveMouseMotion event arrived
+void noteMotion();
+
+// input stage: tessellation step and extras for the next build
+void fillQuality(InputState& input);
+
+// idle (no build in flight): publish the next refinement step, true while more are pending
+bool refineQualityWhenIdle();
+
+// render stage: cost of a frame built at the given level (build + submit)
+void recordFrameTime(int level, double ms);
+
+#endif // QUALITY_H
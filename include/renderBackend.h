@@ -0,0 +1,41 @@
+#ifndef RENDER_BACKEND_H
+#define RENDER_BACKEND_H
+
+#include <cstddef>
+#include <cstdint>
+#include "camera.h"
+#include "FrameGeometry.h"
+
+// Destino dos desenhos de vértices: OpenGL (padrão) ou o rasterizador em CPU.
+// Only the vertex paths go through here; conics, text and the gallery stay GL-only. This header
+// and renderBackend.cpp do not depend on GL, so headless builds can link them without it.
+
+// draw calls and vertices sent to the backend since the start of the frame, for the HUD
+struct RenderStats {
+    int drawCalls = 0;
+    size_t verticesUploaded = 0;
+};
+extern RenderStats renderStats;
+
+class RenderBackend {
+public:
+    virtual ~RenderBackend() = default;
+
+    // interleaved x,y,r,g,b world positions
+    virtual void drawVertices(const float* data, size_t floatCount, PrimitiveMode mode, const ViewTransform& view) = 0;
+
+    // packed ranges concatenated and drawn batch by batch, see drawIndexedRanges in graphics.h
+    virtual void drawIndexedRanges(const ViewTransform& view, const DrawRange* ranges, size_t rangeCount,
+                                   const uint32_t* indices, size_t indexCount, const DrawBatch* batches, size_t batchCount) = 0;
+
+    virtual const char* name() const = 0;
+};
+
+// the GL implementation (graphics.cpp); initGLResources makes it the active backend
+RenderBackend& glRenderBackend();
+
+// every drawVertices / drawIndexedRanges call goes to this backend; one has to be set first
+RenderBackend& activeRenderBackend();
+void setRenderBackend(RenderBackend& backend);
+
+#endif // RENDER_BACKEND_H
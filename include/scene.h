@@ -0,0 +1,36 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <cstdint>
+#include <cstdio>
+#include "FrameGeometry.h"
+#include "pipeline.h"
+#include "textOverlay.h"
+
+// Geometria de um quadro a partir do estado de entrada, sem chamadas GL, em duas camadas:
+// o fundo (discos, retas e marcadores confirmados, reta de Pappus) muda só quando os pontos mudam,
+// a frente (ponto em posicionamento, ponto interativo e sua imagem) a cada movimento do mouse.
+// scene.cpp links without GL, for the headless render.
+void buildBackgroundLayer(const InputState& input, FrameGeometry& frame);
+void buildForegroundLayer(const InputState& input, FrameGeometry& frame);
+// names of the marked points and of the intersections, anchored on the disks; returns how many
+int buildSceneLabels(const InputState& input, TextLabel* labels);
+// interactive point and its image (point x, y, image x, y in disk coordinates); false if there is none
+bool interactiveCorrespondence(const InputState& input, double out[4]);
+// Pappus line the background draws: exact for the six marked points, the least-squares fit once
+// both lines have extra points; false before the six points are in
+bool drawnPappusAxis(const InputState& input, Vector3& axis);
+// identifies the background built from this input; equal keys mean identical layers
+uint64_t backgroundLayerKey(const InputState& input);
+
+// x1 y1 .. x3 y3 u1 v1 .. u3 v3 of a compute server record and the optional interactive point
+const int SCENE_RECORD_VALUES = 14;
+// numbers of the first non-blank line of the input, at most SCENE_RECORD_VALUES; 0 at the end
+int readSceneRecord(FILE* in, double values[SCENE_RECORD_VALUES]);
+
+// scene of one compute server record as the interactive view would show it with all six points
+// fixed: values holds x1 y1 .. x3 y3 u1 v1 .. u3 v3 and optionally the interactive point
+void buildRecordScene(const double* values, int valueCount, int width, int height,
+                      FrameGeometry& background, FrameGeometry& foreground);
+
+#endif // SCENE_H
@@ -0,0 +1,75 @@
+#ifndef SCENE_SHADERS_H
+#define SCENE_SHADERS_H
+
+// Shaders do programa principal da cena, compartilhados com tools/replayDrawStream.cpp para que
+// o reenvio desenhe exatamente como o aplicativo.
+
+// Improved vertex shader: positions arrive relative to the camera, uView scales them to clip space
+const char* const vertexShaderSrc = R"glsl(
+#version 330 core
+layout(location = 0) in vec2 inPos;
+layout(location = 1) in vec3 inColor; // constant per draw unless the interleaved layout is bound
+layout(location = 2) in vec2 inTexCoord; // glyph atlas coordinates, text only
+out vec3 fragColor;
+out vec2 texCoord;
+uniform float uPointSize;
+uniform int uIsPoint;
+uniform mat3 uView;
+uniform vec2 uOrigin;
+uniform float uPositionScale;
+// hemisphere view: disk positions are lifted onto the sphere of their disk and rotated
+uniform int uLift;
+uniform mat3 uRotation;
+uniform vec2 uDisk1, uDisk2; // disk centers relative to the view center
+uniform float uRadius;
+void main() {
+    fragColor = inColor;
+    texCoord = inTexCoord;
+    vec2 relativePos = uOrigin + inPos * uPositionScale;
+    if(uLift == 1) {
+        vec2 disk = distance(relativePos, uDisk1) < distance(relativePos, uDisk2) ? uDisk1 : uDisk2;
+        vec2 p = relativePos - disk;
+        vec3 q = uRotation * vec3(p, sqrt(max(uRadius * uRadius - dot(p, p), 0.0)));
+        relativePos = disk + q.xy;
+        // the far side shows through the open hemisphere, dimmed
+        if(q.z < 0.0) fragColor *= 0.35;
+    }
+    gl_Position = vec4((uView * vec3(relativePos, 1.0)).xy, 0.0, 1.0);
+    if(uIsPoint == 1) {
+        gl_PointSize = uPointSize;
+    }
+}
+)glsl";
+
+// Improved fragment shader: support alpha and smooth round points using gl_PointCoord
+const char* const fragmentShaderSrc = R"glsl(
+#version 330 core
+in vec3 fragColor;
+in vec2 texCoord;
+out vec4 outColor;
+uniform float uAlpha;
+uniform int uIsPoint;
+uniform int uIsText;
+uniform sampler2D uGlyphAtlas;
+void main() {
+    float alpha = uAlpha;
+    // If rendering points, make them round and smooth using gl_PointCoord
+    if(uIsPoint == 1) {
+        // gl_PointCoord is only valid for points
+        vec2 pc = gl_PointCoord.xy - vec2(0.5);
+        float dist = length(pc);
+        // smoothstep to create soft circular alpha (0.0..0.5 radius)
+        float smoothA = smoothstep(0.5, 0.45, dist);
+        alpha *= smoothA;
+    }
+    // glyph coverage from the signed distance, the edge is at 0.5 and about one pixel wide at any scale
+    if(uIsText == 1) {
+        float d = texture(uGlyphAtlas, texCoord).r;
+        float w = max(fwidth(d), 1e-4);
+        alpha *= smoothstep(0.5 - w, 0.5 + w, d);
+    }
+    outColor = vec4(fragColor, alpha);
+}
+)glsl";
+
+#endif // SCENE_SHADERS_H
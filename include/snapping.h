@@ -0,0 +1,83 @@
+#ifndef SNAPPING_H
+#define SNAPPING_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "Vector3.h"
+#include "GreatCircle.h"
+
+// Atração do cursor para pontos e retas da construção, indexados numa grade uniforme por disco
+const double SNAP_TOLERANCE_PIXELS = 8.0;
+// grid cell side in disk units
+const double SNAP_CELL_SIZE = 16.0;
+// a projected great circle is indexed as a closed polyline with this many segments
+const int SNAP_LINE_SEGMENTS = 128;
+
+// Uniform grid over one disk with the cells hashed by their integer coordinates. A feature is a
+// point or a projected great circle in disk coordinates, listed in every cell it touches; setting
+// or removing one only visits its own cells, and a lookup only the cells around the query.
+class SpatialHash {
+public:
+    struct Hit {
+        bool found = false;
+        bool isLine = false;
+        uint32_t id = 0;
+        double x = 0.0, y = 0.0; // the point, or the closest position on the line
+        Vector3 normal;          // lines only
+    };
+
+    explicit SpatialHash(double cellSize = SNAP_CELL_SIZE) : cellSize(cellSize) {}
+
+    // (re)index a feature; nothing happens when it is unchanged
+    void setPoint(uint32_t id, double x, double y);
+    void setLine(uint32_t id, const Vector3& normal, double radius);
+    void remove(uint32_t id);
+    void clear();
+    size_t featureCount() const { return features.size(); }
+
+    // nearest point within tolerance, otherwise the nearest line within tolerance; skips excludeId
+    Hit nearest(double x, double y, double tolerance, uint32_t excludeId = UINT32_MAX) const;
+
+private:
+    struct Feature {
+        bool isLine = false;
+        Vector3 normal;
+        std::vector<double> xy; // the point, or the polyline vertices
+        std::vector<uint64_t> cells;
+    };
+    // feature and, for lines, the segment starting at vertex `segment`
+    struct Entry {
+        uint32_t feature;
+        uint32_t segment;
+    };
+
+    uint64_t cellKey(long cx, long cy) const;
+    long cellOf(double v) const;
+    void insert(uint32_t id, Feature& feature);
+
+    double cellSize;
+    std::unordered_map<uint64_t, std::vector<Entry>> cells;
+    std::unordered_map<uint32_t, Feature> features;
+};
+
+extern bool snappingEnabled;
+
+// reindex what changed in the construction (confirmed points, their lines, intersections,
+// extra points); called by the GLUT thread after every edit of the points
+void updateSnapFeatures();
+// index the Pappus axis of the scene on screen, which is fitted by the compute stage once there
+// are extra points; called by the render stage with every scene it acquires
+void updateSnapAxis(uint64_t backgroundKey, bool hasAxis, const Vector3& axis);
+
+// free point on disk 0 or 1, disk coordinates: moved onto the nearest feature if one is close
+bool snapFreePoint(int disk, double& x, double& y);
+
+// point bound to the base line of the disk, already on it: moved to the nearest point feature,
+// or to where the nearest line feature crosses the base line
+bool snapOnBaseLine(int disk, double& x, double& y);
+
+// key K
+void toggleSnapping();
+
+#endif // SNAPPING_H
@@ -0,0 +1,15 @@
+#ifndef STARTUP_TIMING_H
+#define STARTUP_TIMING_H
+
+// Medição da inicialização, de main até o primeiro quadro apresentado
+
+// first statement of main
+void startStartupTiming();
+
+// close the phase that started at the previous mark
+void markStartupPhase(const char* name);
+
+// call after every presented frame; the first one with content prints the report
+void noteFramePresented(bool hasContent);
+
+#endif // STARTUP_TIMING_H
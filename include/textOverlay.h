@@ -0,0 +1,26 @@
+#ifndef TEXT_OVERLAY_H
+#define TEXT_OVERLAY_H
+
+#include "camera.h"
+
+// Texto sobreposto: atlas de distâncias com sinal gerado na partida, rótulos e HUD num único draw
+const int MAX_LABEL_LENGTH = 8;
+const int MAX_SCENE_LABELS = 16;
+
+// text anchored next to a world point
+struct TextLabel {
+    char text[MAX_LABEL_LENGTH];
+    double x, y;
+    float color[3];
+};
+
+extern bool showTextOverlay;
+
+// bake the glyph atlas into a texture, once
+void initTextOverlay();
+
+// labels next to their points and the HUD lines in the top left corner, one draw call for all;
+// hud may be null
+void drawTextOverlay(const TextLabel* labels, int labelCount, const ViewTransform& view, const char* hud);
+
+#endif // TEXT_OVERLAY_H
@@ -0,0 +1,25 @@
+#ifndef TRAIL_H
+#define TRAIL_H
+
+#include <cstdint>
+#include "camera.h"
+
+// Rastro: as últimas posições do ponto interativo e de sua imagem, esmaecendo com a idade.
+// Entries live in a GPU ring buffer; appending one is a single sub-range upload and the
+// whole trail is one instanced draw, with the age of every entry worked out in the shader.
+const int TRAIL_CAPACITY = 512;
+
+extern bool showTrail;
+
+void initTrailResources();
+
+// the interactive point (disk 1) and its image (disk 2) in disk coordinates
+void appendTrail(double pointX, double pointY, double imageX, double imageY);
+void clearTrail();
+
+void drawTrail(const ViewTransform& view);
+
+// key T
+void toggleTrail();
+
+#endif // TRAIL_H
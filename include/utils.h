@@ -1,10 +1,11 @@
 #ifndef UTILS_H
 #define UTILS_H
 #include "Matrix3.h"
+#include "GreatCircle.h"
 
-#include <GL/glew.h>
-#include <GL/glut.h>
 #include <tuple>
+#include <cstddef>
+#include <cstdint>
 
 const int INITIAL_WINDOW_WIDTH = 1366;
 const int INITIAL_WINDOW_HEIGHT = 768;
@@ -12,6 +13,16 @@ const int WORLD_LEFT = -780;
 const int WORLD_RIGHT = 780;
 const int WORLD_BOTTOM = -420;
 const int WORLD_TOP = 420;
+// angular step used to tessellate a disk-sized curve at zoom 1; other sizes and zoom levels
+// scale it so that the vertex spacing in pixels stays the same
+const double TESSELLATION_STEP = 0.001;
+
+// streamed vertex: 16-bit position relative to an origin, in units of extent / QUANTIZATION_MAX;
+// origin, extent and color are set once per draw
+struct PackedVertex {
+    int16_t x, y;
+};
+const float QUANTIZATION_MAX = 32767.0f;
 
 // Dynamic window size tracking
 extern int currentWindowWidth;
@@ -25,24 +36,40 @@ extern std::tuple<double, double, int ,int> markedPoints[6];
 extern const int offsetCircle1X, offsetCircle1Y;
 extern const int offsetCircle2X, offsetCircle2Y;
 extern int circleRadius;
-extern int worldX, worldY;
+extern double worldX, worldY;
 extern double infinityThreshold;
 extern bool isIdealLine[2];
-extern Matrix3 lineTransformations[2];
-extern std::tuple<double, bool> lineBaseRotations[2];
+// lines of the first and second triples, used to keep new points on them
+extern GreatCircle baseLines[2];
 extern std::tuple<double, double> interactivePoint;
 extern bool canDrawInteractivePoint;
+// points marked on each line beyond its triple (key E), relative to the disk center;
+// the axis is then fitted by least squares over 3 + min(count) points per line
+const int MAX_EXTRA_POINTS = 4093;
+extern std::tuple<double, double> extraPoints[2][MAX_EXTRA_POINTS];
+extern int extraPointCount[2];
+// bumped on every change so the fit is redone only when needed
+extern uint64_t extraPointsVersion;
+extern bool extraPointMode;
+// point following the mouse in extra-point mode, on line extraCandidateLine (-1: none)
+extern std::tuple<double, double> extraCandidate;
+extern int extraCandidateLine;
 void myInit(void);
-void mouseToWorldCoords(int mouseX, int mouseY, int& worldX, int& worldY);
+// world point under a window pixel for the current camera
+void mouseToWorldCoords(int mouseX, int mouseY, double& worldX, double& worldY);
 void reshapeCallback(int width, int height);
 void keyboardCallback(unsigned char key, int x, int y);
+// arrow keys pan the camera
+void specialKeyCallback(int key, int x, int y);
 double calcNorm2d(double distanceX, double distanceY);
 void capDistance2D(double& distanceX, double& distanceY);
 bool checkInfinityPoint(double px, double dy);
 bool checkLinePointsDifferent(const Vector3& point1, const Vector3& point2);
 Vector3 liftToSphere(double x, double y, double radius);
 void getLinePoints(int startIdx, Vector3& p1, Vector3& p2, double radius);
-// drawOpposite default true to preserve previous behavior; set false to avoid drawing opposite-side vertices
-void drawProjectedLine(const Matrix3& transformation, float offsetX, float offsetY, float radius, double sinXval, Vector3 linecolor = Vector3(0.2,0.2,0.2));
+// count vertices of center + a cos t + b sin t at t = t0 + k * step, in units of extent / QUANTIZATION_MAX;
+// the center is given relative to the origin of the strip
+void tessellateEllipse(PackedVertex* out, size_t count, double centerX, double centerY,
+                       double ax, double ay, double bx, double by, double t0, double step, float extent);
 Vector3 lineIntersection(const Vector3 &line1, const Vector3 &line2);
 #endif
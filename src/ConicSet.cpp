@@ -0,0 +1,55 @@
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include "conics.h"
+
+void ConicSet::clear() {
+    diskCount = 0;
+    dropped = 0;
+}
+
+ConicDisk* ConicSet::findDisk(float offsetX, float offsetY) {
+    for(int d = 0; d < diskCount; d++) {
+        if(disks[d].offsetX == offsetX && disks[d].offsetY == offsetY) return &disks[d];
+    }
+    if(diskCount == MAX_CONIC_DISKS) return nullptr;
+    ConicDisk& disk = disks[diskCount++];
+    disk.offsetX = offsetX;
+    disk.offsetY = offsetY;
+    disk.count = 0;
+    return &disk;
+}
+
+bool ConicSet::addConic(float offsetX, float offsetY, float centerX, float centerY,
+                        float a00, float a10, float a01, float a11,
+                        Vector3 color, bool fullEllipse) {
+    ConicDisk* disk = findDisk(offsetX, offsetY);
+    if(disk == nullptr || disk->count == MAX_CONICS_PER_DISK) {
+        // every frame would repeat it; the per-frame count goes with the allocation stats
+        static std::atomic<bool> warned(false);
+        if(!warned.exchange(true)) std::cerr << "Conic buffer full, tessellating the remaining curves" << std::endl;
+        dropped++;
+        return false;
+    }
+    int i = disk->count++;
+    float* axes = disk->block.axes[i];
+    axes[0] = a00; axes[1] = a10; axes[2] = a01; axes[3] = a11;
+    float* centerFlags = disk->block.centerFlags[i];
+    centerFlags[0] = centerX; centerFlags[1] = centerY;
+    centerFlags[2] = fullEllipse ? 1.0f : 0.0f; centerFlags[3] = 0.0f;
+    float* rgba = disk->block.colors[i];
+    rgba[0] = color[0]; rgba[1] = color[1]; rgba[2] = color[2]; rgba[3] = 1.0f;
+    return true;
+}
+
+bool ConicSet::addProjectedLine(const GreatCircle& line, float offsetX, float offsetY, float radius, bool drawOpposite, Vector3 color) {
+    // the tessellated path also draws the opposite half when the line is close to the ideal line
+    return addConic(offsetX, offsetY, 0, 0,
+             radius * line.u()[0], radius * line.u()[1],
+             radius * line.v()[0], radius * line.v()[1],
+             color, drawOpposite);
+}
+
+bool ConicSet::addCircle(float offsetX, float offsetY, float centerX, float centerY, float radius, Vector3 color) {
+    return addConic(offsetX, offsetY, centerX, centerY, radius, 0, 0, radius, color, true);
+}
@@ -0,0 +1,212 @@
+#include "Dataset.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <numeric>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "utils.h"
+
+static const size_t PAGE_BYTES = 4096;
+static const size_t TARGET_CHUNK_BYTES = 4 * 1024 * 1024;
+
+static std::string systemError(const char* what) {
+    return std::string(what) + ": " + strerror(errno);
+}
+
+// ---- Reader ----
+
+DatasetReader::~DatasetReader() {
+    close();
+}
+
+void DatasetReader::close() {
+    if(mapping) munmap(mapping, mappingBytes);
+    mapping = nullptr;
+    mappingBytes = 0;
+    data = nullptr;
+    count = 0;
+    first = 0;
+}
+
+bool DatasetReader::open(const std::string& path, uint32_t expectedKind, uint64_t byteBegin, uint64_t byteEnd) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0) {
+        lastError = systemError(path.c_str());
+        return false;
+    }
+    bool ok = pread(fd, &fileHeader, sizeof(fileHeader), 0) == (ssize_t)sizeof(fileHeader);
+    if(!ok || fileHeader.magic != DATASET_MAGIC) {
+        lastError = path + ": not a dataset file";
+    }
+    else if(fileHeader.version != DATASET_VERSION) {
+        lastError = path + ": unsupported dataset version " + std::to_string(fileHeader.version);
+    }
+    else if(fileHeader.kind != expectedKind) {
+        lastError = path + ": unexpected dataset kind";
+    }
+    else if(fileHeader.recordBytes != datasetRecordBytes(expectedKind)) {
+        lastError = path + ": record size " + std::to_string(fileHeader.recordBytes) + " does not match the dataset kind";
+    }
+    else {
+        // records past the count are fine (an interrupted append), missing ones are not
+        struct stat info;
+        uint64_t maxCount = (UINT64_MAX - DATASET_HEADER_BYTES) / fileHeader.recordBytes;
+        if(fstat(fd, &info) != 0) {
+            lastError = systemError(path.c_str());
+        }
+        else if(fileHeader.recordCount > maxCount ||
+                (uint64_t)info.st_size < DATASET_HEADER_BYTES + fileHeader.recordCount * fileHeader.recordBytes) {
+            lastError = path + ": truncated, the header counts " + std::to_string(fileHeader.recordCount) + " records";
+        }
+        else {
+            lastError.clear();
+        }
+    }
+    if(!lastError.empty()) {
+        ::close(fd);
+        return false;
+    }
+
+    // records whose first byte falls inside the requested range
+    uint64_t recordBytes = fileHeader.recordBytes;
+    auto recordAt = [&](uint64_t byte) -> uint64_t {
+        if(byte <= DATASET_HEADER_BYTES) return 0;
+        return std::min<uint64_t>((byte - DATASET_HEADER_BYTES + recordBytes - 1) / recordBytes, fileHeader.recordCount);
+    };
+    uint64_t begin = recordAt(byteBegin);
+    uint64_t end = byteEnd == UINT64_MAX ? fileHeader.recordCount : recordAt(byteEnd);
+    first = begin;
+    count = end > begin ? end - begin : 0;
+    if(count == 0) {
+        ::close(fd);
+        return true;
+    }
+
+    // the mapping has to start on a page boundary, the records start a little after it
+    uint64_t dataOffset = DATASET_HEADER_BYTES + begin * recordBytes;
+    uint64_t mapOffset = dataOffset & ~(uint64_t)(PAGE_BYTES - 1);
+    mappingBytes = dataOffset - mapOffset + count * recordBytes;
+    mapping = mmap(nullptr, mappingBytes, PROT_READ, MAP_SHARED, fd, (off_t)mapOffset);
+    ::close(fd);
+    if(mapping == MAP_FAILED) {
+        mapping = nullptr;
+        count = 0;
+        lastError = systemError(path.c_str());
+        return false;
+    }
+    madvise(mapping, mappingBytes, MADV_SEQUENTIAL);
+    data = (const char*)mapping + (dataOffset - mapOffset);
+    return true;
+}
+
+// ---- Writer ----
+
+DatasetWriter::~DatasetWriter() {
+    if(fd >= 0) close();
+}
+
+bool DatasetWriter::open(const std::string& path, uint32_t kind, uint32_t recordBytes, bool append) {
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | (append ? 0 : O_TRUNC), 0644);
+    if(fd < 0) {
+        lastError = systemError(path.c_str());
+        return false;
+    }
+    fileHeader = {DATASET_MAGIC, DATASET_VERSION, kind, recordBytes, 0, (double)circleRadius};
+    written = 0;
+    staged = 0;
+
+    DatasetHeader existing;
+    if(append && pread(fd, &existing, sizeof(existing), 0) == (ssize_t)sizeof(existing)) {
+        if(existing.magic != DATASET_MAGIC || existing.version != DATASET_VERSION ||
+           existing.kind != kind || existing.recordBytes != recordBytes) {
+            lastError = path + ": cannot append, dataset layout differs";
+            ::close(fd);
+            fd = -1;
+            return false;
+        }
+        fileHeader = existing;
+        written = existing.recordCount;
+        // drop anything past the published count, e.g. records of an interrupted run
+        if(ftruncate(fd, (off_t)(DATASET_HEADER_BYTES + written * recordBytes)) != 0) {
+            lastError = systemError(path.c_str());
+            ::close(fd);
+            fd = -1;
+            return false;
+        }
+    }
+    else if(!writeHeader()) {
+        return false;
+    }
+
+    // chunks are a multiple of the page size and start on chunk boundaries of the record index,
+    // so every full chunk lands page aligned in the file
+    size_t alignRecords = PAGE_BYTES / std::gcd((size_t)recordBytes, PAGE_BYTES);
+    chunkRecords = std::max<size_t>(1, TARGET_CHUNK_BYTES / (alignRecords * recordBytes)) * alignRecords;
+    chunk = static_cast<char*>(aligned_alloc(PAGE_BYTES, chunkRecords * recordBytes));
+    return chunk != nullptr;
+}
+
+bool DatasetWriter::append(const void* records, size_t recordCount) {
+    const char* source = static_cast<const char*>(records);
+    size_t recordBytes = fileHeader.recordBytes;
+    while(recordCount > 0) {
+        // fill up to the next chunk boundary of the record index
+        size_t room = chunkRecords - (written + staged) % chunkRecords;
+        size_t take = std::min(room, recordCount);
+        memcpy(chunk + staged * recordBytes, source, take * recordBytes);
+        staged += take;
+        source += take * recordBytes;
+        recordCount -= take;
+        if(take == room && !flushChunk()) return false;
+    }
+    return true;
+}
+
+bool DatasetWriter::flushChunk() {
+    if(staged == 0) return true;
+    size_t recordBytes = fileHeader.recordBytes;
+    size_t bytes = staged * recordBytes;
+    off_t offset = (off_t)(DATASET_HEADER_BYTES + written * recordBytes);
+    const char* cursor = chunk;
+    while(bytes > 0) {
+        ssize_t done = pwrite(fd, cursor, bytes, offset);
+        if(done < 0) {
+            if(errno == EINTR) continue;
+            lastError = systemError("dataset write");
+            return false;
+        }
+        cursor += done;
+        offset += done;
+        bytes -= (size_t)done;
+    }
+    written += staged;
+    staged = 0;
+    return true;
+}
+
+bool DatasetWriter::writeHeader() {
+    char page[DATASET_HEADER_BYTES] = {};
+    fileHeader.recordCount = written;
+    memcpy(page, &fileHeader, sizeof(fileHeader));
+    if(pwrite(fd, page, sizeof(page), 0) != (ssize_t)sizeof(page)) {
+        lastError = systemError("dataset header");
+        return false;
+    }
+    return true;
+}
+
+bool DatasetWriter::close() {
+    bool ok = flushChunk();
+    // records first, count last: readers of a crashed run see only complete records
+    if(ok) ok = fdatasync(fd) == 0 && writeHeader();
+    ::close(fd);
+    fd = -1;
+    free(chunk);
+    chunk = nullptr;
+    return ok;
+}
@@ -0,0 +1,51 @@
+#include "FrameArena.h"
+#include <algorithm>
+#include <cstdint>
+
+static const size_t MIN_BLOCK_SIZE = 64 * 1024;
+
+FrameArena::~FrameArena() {
+    for(Block& block : blocks) delete[] block.data;
+}
+
+void* FrameArena::allocateBytes(size_t bytes, size_t alignment) {
+    if(!blocks.empty()) {
+        Block& last = blocks.back();
+        uintptr_t base = (uintptr_t)last.data;
+        size_t aligned = ((base + offset + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base;
+        if(aligned + bytes <= last.size) {
+            offset = aligned + bytes;
+            return last.data + aligned;
+        }
+        usedInFullBlocks += offset;
+    }
+    // spill: grow geometrically so a frame needs few extra blocks before reset() merges them
+    size_t size = std::max({bytes + alignment, capacity(), MIN_BLOCK_SIZE});
+    blocks.push_back({new char[size], size});
+    Block& block = blocks.back();
+    uintptr_t base = (uintptr_t)block.data;
+    size_t aligned = ((base + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base;
+    offset = aligned + bytes;
+    return block.data + aligned;
+}
+
+void FrameArena::reset() {
+    if(blocks.size() > 1) {
+        size_t total = capacity();
+        for(Block& block : blocks) delete[] block.data;
+        blocks.clear();
+        blocks.push_back({new char[total], total});
+    }
+    offset = 0;
+    usedInFullBlocks = 0;
+}
+
+size_t FrameArena::capacity() const {
+    size_t total = 0;
+    for(const Block& block : blocks) total += block.size;
+    return total;
+}
+
+size_t FrameArena::used() const {
+    return usedInFullBlocks + offset;
+}
@@ -0,0 +1,186 @@
+#include "FrameGeometry.h"
+#include "renderBackend.h"
+#include "utils.h"
+#include <algorithm>
+#include <cmath>
+
+void FrameGeometry::clear() {
+    arena.reset();
+    ranges.clear();
+    jobs.clear();
+    conics.clear();
+    batches.clear();
+    indices = nullptr;
+    indexCount = 0;
+}
+
+PackedVertex* FrameGeometry::appendStrip(size_t vertexCount, PrimitiveMode mode, double originX, double originY, float extent, Vector3 color) {
+    PackedVertex* data = arena.allocate<PackedVertex>(vertexCount);
+    ranges.push_back({mode, data, vertexCount, originX, originY, extent,
+                      {(float)color[0], (float)color[1], (float)color[2]}});
+    return data;
+}
+
+void FrameGeometry::appendRing(double centerX, double centerY, double radius, Vector3 color) {
+    queueCurve({centerX, centerY, radius, 0, 0, radius, 0, 2 * M_PI, radius}, color);
+}
+
+void FrameGeometry::appendPoints(const std::tuple<double, double>* points, size_t count, double offsetX, double offsetY,
+                                 double radius, Vector3 color) {
+    if(count == 0) return;
+    double originX = offsetX, originY = offsetY;
+    float extent = (float)(radius * RING_EXTENT_RADII);
+    // dots are a few pixels wide, keep the ones whose disk touches the view
+    double margin = 8.0 * view.pixelSize;
+    size_t visible = 0;
+    for(size_t k = 0; k < count; k++) {
+        double x = offsetX + std::get<0>(points[k]), y = offsetY + std::get<1>(points[k]);
+        if(view.overlaps(x, y, x, y, margin)) visible++;
+    }
+    if(visible == 0) return;
+    if(extent / QUANTIZATION_MAX > view.pixelSize / CURVE_GRID_PER_PIXEL) {
+        // the disk grid is too coarse for this zoom, quantize around the view instead
+        originX = view.centerX;
+        originY = view.centerY;
+        extent = (float)((std::max(view.halfWidth(), view.halfHeight()) + margin) * RING_EXTENT_RADII);
+    }
+    PackedVertex* out = appendStrip(visible, PRIMITIVE_POINTS, originX, originY, extent, color);
+    double scale = QUANTIZATION_MAX / extent;
+    for(size_t k = 0; k < count; k++) {
+        double x = offsetX + std::get<0>(points[k]), y = offsetY + std::get<1>(points[k]);
+        if(!view.overlaps(x, y, x, y, margin)) continue;
+        *out++ = {(int16_t)lround((x - originX) * scale), (int16_t)lround((y - originY) * scale)};
+    }
+}
+
+void FrameGeometry::addCircle(double offsetX, double offsetY, double centerX, double centerY, double radius, Vector3 color) {
+    if(analyticConics && conics.addCircle(offsetX, offsetY, centerX, centerY, radius, color)) return;
+    appendRing(offsetX + centerX, offsetY + centerY, radius, color);
+}
+
+void FrameGeometry::addProjectedLine(const Vector3& p1, const Vector3& p2, float offsetX, float offsetY, float radius, Vector3 color, bool arcOnly) {
+    GreatCircle line = GreatCircle::through(p1, p2);
+    bool drawOpposite = !arcOnly && drawExtras && line.needsOppositeHalf();
+    // a disk whose conic buffer is full gets the tessellated curve instead
+    if(analyticConics && conics.addProjectedLine(line, offsetX, offsetY, radius, drawOpposite, color)) return;
+    // draw only the arc from 0..PI (half circle) to avoid drawing the diameter
+    Curve arc = {offsetX, offsetY,
+                 radius * line.u()[0], radius * line.u()[1],
+                 radius * line.v()[0], radius * line.v()[1],
+                 0, M_PI, radius};
+    queueCurve(arc, color);
+    if(drawOpposite) {
+        Curve opposite = arc;
+        opposite.ax = -arc.ax; opposite.ay = -arc.ay;
+        opposite.bx = -arc.bx; opposite.by = -arc.by;
+        queueCurve(opposite, color);
+    }
+}
+
+// splits [t0, t1] until a piece is either off screen or short on screen; any point of a piece
+// lies within speed * (t1 - t0) / 2 of one of its ends
+void FrameGeometry::findVisibleRuns(const Curve& curve, double speed, double t0, double t1, int depth) {
+    double x0 = curve.centerX + curve.ax * cos(t0) + curve.bx * sin(t0);
+    double y0 = curve.centerY + curve.ay * cos(t0) + curve.by * sin(t0);
+    double x1 = curve.centerX + curve.ax * cos(t1) + curve.bx * sin(t1);
+    double y1 = curve.centerY + curve.ay * cos(t1) + curve.by * sin(t1);
+    double pad = speed * (t1 - t0) * 0.5;
+    double minX = std::min(x0, x1) - pad, maxX = std::max(x0, x1) + pad;
+    double minY = std::min(y0, y1) - pad, maxY = std::max(y0, y1) + pad;
+    // a couple of pixels of margin for the smoothed line edges
+    if(!view.overlaps(minX, minY, maxX, maxY, 2.0 * view.pixelSize)) return;
+
+    if(speed * (t1 - t0) > CULL_PIECE_PIXELS * view.pixelSize && depth < 48) {
+        double mid = 0.5 * (t0 + t1);
+        findVisibleRuns(curve, speed, t0, mid, depth + 1);
+        findVisibleRuns(curve, speed, mid, t1, depth + 1);
+        return;
+    }
+    if(!runs.empty() && runs.back().t1 == t0) {
+        VisibleRun& run = runs.back();
+        run.t1 = t1;
+        run.minX = std::min(run.minX, minX); run.minY = std::min(run.minY, minY);
+        run.maxX = std::max(run.maxX, maxX); run.maxY = std::max(run.maxY, maxY);
+        return;
+    }
+    runs.push_back({t0, t1, minX, minY, maxX, maxY});
+}
+
+void FrameGeometry::queueCurve(const Curve& curve, Vector3 color) {
+    // largest singular value of the axes: the fastest the curve moves per radian
+    double trace = curve.ax * curve.ax + curve.ay * curve.ay + curve.bx * curve.bx + curve.by * curve.by;
+    double det = curve.ax * curve.by - curve.bx * curve.ay;
+    double speed = sqrt(0.5 * (trace + sqrt(std::max(trace * trace - 4 * det * det, 0.0))));
+    if(speed <= 0) return;
+
+    runs.clear();
+    const int initialPieces = 16;
+    double piece = (curve.t1 - curve.t0) / initialPieces;
+    for(int i = 0; i < initialPieces; i++) {
+        findVisibleRuns(curve, speed, curve.t0 + i * piece, i + 1 == initialPieces ? curve.t1 : curve.t0 + (i + 1) * piece, 0);
+    }
+    if(runs.empty()) return;
+
+    // constant spacing in pixels: the step shrinks with the zoom and with the size of the curve
+    double step = std::min(tessellationStep * circleRadius / (speed * view.zoom), M_PI / 16);
+    // the curve's own grid while it is fine enough for this zoom, else one grid per run
+    float curveExtent = (float)(curve.radius * RING_EXTENT_RADII);
+    bool ownGrid = curveExtent / QUANTIZATION_MAX <= view.pixelSize / CURVE_GRID_PER_PIXEL;
+    for(const VisibleRun& run : runs) {
+        // both ends exactly: rings close and arcs reach the rim without running past it
+        size_t count = std::min(std::max((size_t)2, (size_t)std::ceil((run.t1 - run.t0) / step) + 1), MAX_RUN_VERTICES);
+        double runStep = (run.t1 - run.t0) / (count - 1);
+        double originX = curve.centerX, originY = curve.centerY;
+        float extent = curveExtent;
+        if(!ownGrid) {
+            originX = 0.5 * (run.minX + run.maxX);
+            originY = 0.5 * (run.minY + run.maxY);
+            extent = (float)(0.5 * std::max(run.maxX - run.minX, run.maxY - run.minY) * RING_EXTENT_RADII);
+        }
+        jobs.push_back({curve, run.t0, runStep, ranges.size()});
+        appendStrip(count, PRIMITIVE_LINE_STRIP, originX, originY, extent, color);
+    }
+}
+
+static bool sharesDrawState(const DrawBatch& batch, const DrawRange& range) {
+    return batch.mode == range.mode && batch.originX == range.originX && batch.originY == range.originY
+        && batch.extent == range.extent && batch.color[0] == range.color[0]
+        && batch.color[1] == range.color[1] && batch.color[2] == range.color[2];
+}
+
+void FrameGeometry::build(TaskPool& pool) {
+    pool.parallelFor(jobs.size(), [this](size_t j) {
+        const CurveJob& job = jobs[j];
+        const Curve& curve = job.curve;
+        DrawRange& range = ranges[job.range];
+        tessellateEllipse(range.data, range.count, curve.centerX - range.originX, curve.centerY - range.originY,
+                          curve.ax, curve.ay, curve.bx, curve.by, job.t0, job.step, range.extent);
+    });
+
+    // discontinuities are known here, so submission never has to look at the vertices
+    indexCount = 0;
+    for(const DrawRange& range : ranges) indexCount += range.count + 1;
+    indices = arena.allocate<uint32_t>(indexCount);
+    size_t next = 0;
+    uint32_t base = 0;
+    for(const DrawRange& range : ranges) {
+        if(batches.empty() || !sharesDrawState(batches.back(), range)) {
+            batches.push_back({range.mode, next, 0, range.originX, range.originY, range.extent,
+                               {range.color[0], range.color[1], range.color[2]}});
+        }
+        for(size_t k = 0; k < range.count; k++) indices[next++] = base + (uint32_t)k;
+        indices[next++] = PRIMITIVE_RESTART_INDEX;
+        base += (uint32_t)range.count;
+        batches.back().indexCount = next - batches.back().firstIndex;
+    }
+}
+
+void FrameGeometry::submit() const {
+    activeRenderBackend().drawIndexedRanges(view, ranges.data(), ranges.size(), indices, indexCount, batches.data(), batches.size());
+}
+
+size_t FrameGeometry::vertexCount() const {
+    size_t total = 0;
+    for(const DrawRange& range : ranges) total += range.count;
+    return total;
+}
@@ -0,0 +1,30 @@
+#include "GreatCircle.h"
+#include <cmath>
+
+GreatCircle::GreatCircle()
+    : basisU(1, 0, 0), basisV(0, 1, 0), basisN(0, 0, 1), basis(Matrix3::identity()) {}
+
+GreatCircle::GreatCircle(const Vector3& normal) : GreatCircle() {
+    // the ideal line (and a degenerate normal) keeps the identity basis
+    if(normal[0] == 0 && normal[1] == 0) return;
+    basisN = (normal[2] < 0 ? normal * -1 : normal).normalize();
+    basisU = Vector3(-basisN[1], basisN[0], 0).normalize();
+    basisV = basisN.cross(basisU);
+    basis = Matrix3(basisU[0], basisV[0], basisN[0],
+                    basisU[1], basisV[1], basisN[1],
+                    basisU[2], basisV[2], basisN[2]);
+}
+
+GreatCircle GreatCircle::through(const Vector3& p1, const Vector3& p2) {
+    return GreatCircle(p1.cross(p2));
+}
+
+Vector3 GreatCircle::project(double x, double y, double radius) const {
+    // coordinate along u in the disk plane, then lifted back onto the upper half circle
+    double along = basisU[0] * x + basisU[1] * y;
+    if(std::abs(along) > radius) {
+        along = radius;
+    }
+    double across = std::sqrt(radius * radius - along * along);
+    return basisU * along + basisV * across;
+}
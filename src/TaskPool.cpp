@@ -0,0 +1,91 @@
+#include "TaskPool.h"
+
+// jobs that call parallelFor themselves run their inner loop inline instead of deadlocking
+static thread_local bool insideTaskPool = false;
+
+TaskPool::TaskPool(unsigned threadCount) {
+    if(threadCount == 0) threadCount = 1;
+    for(unsigned i = 1; i < threadCount; i++) {
+        workers.emplace_back(&TaskPool::workerLoop, this);
+    }
+}
+
+TaskPool::~TaskPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for(std::thread& worker : workers) worker.join();
+}
+
+unsigned TaskPool::size() const {
+    return (unsigned)workers.size() + 1;
+}
+
+TaskPool& TaskPool::shared() {
+    static TaskPool pool;
+    return pool;
+}
+
+void TaskPool::runBatch(Batch& batch) {
+    bool wasInside = insideTaskPool;
+    insideTaskPool = true;
+    size_t completed = 0;
+    for(;;) {
+        size_t i = batch.next.fetch_add(1);
+        if(i >= batch.count) break;
+        (*batch.job)(i);
+        completed++;
+    }
+    insideTaskPool = wasInside;
+    if(completed > 0 && batch.pending.fetch_sub(completed) == completed) {
+        std::lock_guard<std::mutex> lock(mutex);
+        done.notify_all();
+    }
+}
+
+void TaskPool::parallelFor(size_t count, const std::function<void(size_t)>& job) {
+    if(count == 0) return;
+    if(workers.empty() || count == 1 || insideTaskPool) {
+        for(size_t i = 0; i < count; i++) job(i);
+        return;
+    }
+
+    std::lock_guard<std::mutex> submitLock(submitMutex);
+    Batch batch;
+    batch.job = &job;
+    batch.count = count;
+    batch.next = 0;
+    batch.pending = count;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        current = &batch;
+        generation++;
+    }
+    wake.notify_all();
+
+    runBatch(batch);
+
+    // the batch lives on this stack frame, so wait for stragglers to let go of it too
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&]{ return batch.pending == 0 && activeWorkers == 0; });
+    current = nullptr;
+}
+
+void TaskPool::workerLoop() {
+    unsigned long seen = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    for(;;) {
+        wake.wait(lock, [&]{ return stopping || (current != nullptr && generation != seen); });
+        if(stopping) return;
+        seen = generation;
+        Batch* batch = current;
+        activeWorkers++;
+        lock.unlock();
+        runBatch(*batch);
+        lock.lock();
+        activeWorkers--;
+        if(activeWorkers == 0) done.notify_all();
+    }
+}
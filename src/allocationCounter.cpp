@@ -0,0 +1,70 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include "allocationCounter.h"
+
+bool showAllocationStats = false;
+
+static std::atomic<uint64_t> allocationCount{0};
+
+uint64_t heapAllocationCount() {
+    return allocationCount.load(std::memory_order_relaxed);
+}
+
+// replacements of the global allocation functions, counting every call
+
+static void* countedAllocate(std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if(size == 0) size = 1;
+    return std::malloc(size);
+}
+
+static void* countedAllocateAligned(std::size_t size, std::align_val_t alignment) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    std::size_t align = (std::size_t)alignment;
+    if(align < sizeof(void*)) align = sizeof(void*);
+    size = (size + align - 1) / align * align;
+    if(size == 0) size = align;
+    return std::aligned_alloc(align, size);
+}
+
+void* operator new(std::size_t size) {
+    void* p = countedAllocate(size);
+    if(!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](std::size_t size) {
+    void* p = countedAllocate(size);
+    if(!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return countedAllocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return countedAllocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    void* p = countedAllocateAligned(size, alignment);
+    if(!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    void* p = countedAllocateAligned(size, alignment);
+    if(!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
@@ -0,0 +1,224 @@
+#include <GL/glew.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include "antialiasing.h"
+#include "graphics.h"
+#include "utils.h"
+#include "capture.h"
+
+AntialiasingMode antialiasingMode = AA_LINE_SMOOTH;
+int antialiasingMeasureFrames = 0;
+
+static const int MSAA_SAMPLES = 4;
+
+static GLuint msaaFbo = 0, msaaColor = 0;
+static GLuint fxaaFbo = 0, fxaaTexture = 0;
+static int targetWidth = 0, targetHeight = 0;
+static int msaaSamples = 0;
+
+static GLuint fxaaProgram = 0;
+static GLuint fxaaVao = 0;
+static GLint uni_uScene = -1;
+static GLint uni_uInverseSize = -1;
+
+// frame cost per mode, from the start of the frame until the GPU finished the resolve;
+// timer queries are not used because software rasterizers defer the work past them
+static std::chrono::steady_clock::time_point frameStart;
+static double measuredMs[AA_MODE_COUNT] = {};
+static int measuredFrames[AA_MODE_COUNT] = {};
+
+// full-screen triangle from gl_VertexID
+static const char* fxaaVertexShaderSrc = R"glsl(
+#version 330 core
+out vec2 uv;
+void main() {
+    vec2 corner = vec2(float((gl_VertexID << 1) & 2), float(gl_VertexID & 2));
+    uv = corner;
+    gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+}
+)glsl";
+
+// FXAA along the local luma gradient, after Lottes' reference implementation
+static const char* fxaaFragmentShaderSrc = R"glsl(
+#version 330 core
+#define FXAA_SPAN_MAX 8.0
+#define FXAA_REDUCE_MUL (1.0 / 8.0)
+#define FXAA_REDUCE_MIN (1.0 / 128.0)
+uniform sampler2D uScene;
+uniform vec2 uInverseSize;
+in vec2 uv;
+out vec4 outColor;
+void main() {
+    vec3 rgbNW = texture(uScene, uv + vec2(-1.0, -1.0) * uInverseSize).rgb;
+    vec3 rgbNE = texture(uScene, uv + vec2(1.0, -1.0) * uInverseSize).rgb;
+    vec3 rgbSW = texture(uScene, uv + vec2(-1.0, 1.0) * uInverseSize).rgb;
+    vec3 rgbSE = texture(uScene, uv + vec2(1.0, 1.0) * uInverseSize).rgb;
+    vec3 rgbM = texture(uScene, uv).rgb;
+    vec3 toLuma = vec3(0.299, 0.587, 0.114);
+    float lumaNW = dot(rgbNW, toLuma);
+    float lumaNE = dot(rgbNE, toLuma);
+    float lumaSW = dot(rgbSW, toLuma);
+    float lumaSE = dot(rgbSE, toLuma);
+    float lumaM = dot(rgbM, toLuma);
+    float lumaMin = min(lumaM, min(min(lumaNW, lumaNE), min(lumaSW, lumaSE)));
+    float lumaMax = max(lumaM, max(max(lumaNW, lumaNE), max(lumaSW, lumaSE)));
+
+    vec2 dir = vec2(-((lumaNW + lumaNE) - (lumaSW + lumaSE)), (lumaNW + lumaSW) - (lumaNE + lumaSE));
+    float dirReduce = max((lumaNW + lumaNE + lumaSW + lumaSE) * (0.25 * FXAA_REDUCE_MUL), FXAA_REDUCE_MIN);
+    float rcpDirMin = 1.0 / (min(abs(dir.x), abs(dir.y)) + dirReduce);
+    dir = clamp(dir * rcpDirMin, vec2(-FXAA_SPAN_MAX), vec2(FXAA_SPAN_MAX)) * uInverseSize;
+
+    vec3 rgbA = 0.5 * (texture(uScene, uv + dir * (1.0 / 3.0 - 0.5)).rgb +
+                       texture(uScene, uv + dir * (2.0 / 3.0 - 0.5)).rgb);
+    vec3 rgbB = rgbA * 0.5 + 0.25 * (texture(uScene, uv + dir * -0.5).rgb +
+                                     texture(uScene, uv + dir * 0.5).rgb);
+    float lumaB = dot(rgbB, toLuma);
+    outColor = vec4((lumaB < lumaMin || lumaB > lumaMax) ? rgbA : rgbB, 1.0);
+}
+)glsl";
+
+void initAntialiasingResources() {
+    fxaaProgram = buildProgram(fxaaVertexShaderSrc, fxaaFragmentShaderSrc);
+    uni_uScene = glGetUniformLocation(fxaaProgram, "uScene");
+    uni_uInverseSize = glGetUniformLocation(fxaaProgram, "uInverseSize");
+    glGenVertexArrays(1, &fxaaVao);
+
+    GLint maxSamples = 0;
+    glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+    msaaSamples = std::min(MSAA_SAMPLES, (int)maxSamples);
+}
+
+// (re)create the offscreen targets when the window size changed
+static void ensureTargets() {
+    if(targetWidth == currentWindowWidth && targetHeight == currentWindowHeight && msaaFbo != 0) return;
+    targetWidth = currentWindowWidth;
+    targetHeight = currentWindowHeight;
+
+    if(msaaFbo == 0) {
+        glGenFramebuffers(1, &msaaFbo);
+        glGenRenderbuffers(1, &msaaColor);
+        glGenFramebuffers(1, &fxaaFbo);
+        glGenTextures(1, &fxaaTexture);
+    }
+    glBindRenderbuffer(GL_RENDERBUFFER, msaaColor);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, msaaSamples, GL_RGBA8, targetWidth, targetHeight);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, msaaFbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, msaaColor);
+
+    glBindTexture(GL_TEXTURE_2D, fxaaTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, targetWidth, targetHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, fxaaFbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, fxaaTexture, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+const char* antialiasingModeName(AntialiasingMode mode) {
+    switch(mode) {
+        case AA_LINE_SMOOTH: return "smooth";
+        case AA_MSAA: return "msaa";
+        case AA_FXAA: return "fxaa";
+        case AA_NONE: return "none";
+        default: return "?";
+    }
+}
+
+bool parseAntialiasingMode(const char* name) {
+    for(int mode = 0; mode < AA_MODE_COUNT; mode++) {
+        if(strcmp(name, antialiasingModeName((AntialiasingMode)mode)) == 0) {
+            antialiasingMode = (AntialiasingMode)mode;
+            return true;
+        }
+    }
+    return false;
+}
+
+void cycleAntialiasingMode() {
+    antialiasingMode = (AntialiasingMode)((antialiasingMode + 1) % AA_MODE_COUNT);
+    if(!capturing()) antialiasingMeasureFrames = AA_MEASURE_FRAMES;
+    printf("anti-aliasing: %s; ms/frame so far:", antialiasingModeName(antialiasingMode));
+    for(int mode = 0; mode < AA_MODE_COUNT; mode++) {
+        if(measuredFrames[mode] == 0) printf(" %s -", antialiasingModeName((AntialiasingMode)mode));
+        else printf(" %s %.2f (%d frames)", antialiasingModeName((AntialiasingMode)mode),
+                    measuredMs[mode] / measuredFrames[mode], measuredFrames[mode]);
+    }
+    printf("\n");
+}
+
+static void resolveMultisample(GLuint framebuffer) {
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, msaaFbo);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+    glBlitFramebuffer(0, 0, targetWidth, targetHeight, 0, 0, targetWidth, targetHeight, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void resumeAntialiasedFrame() {
+    if(antialiasingMode == AA_MSAA || antialiasingMode == AA_FXAA) {
+        ensureTargets();
+        glBindFramebuffer(GL_FRAMEBUFFER, antialiasingMode == AA_MSAA ? msaaFbo : fxaaFbo);
+    }
+    else {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+}
+
+void beginAntialiasedFrame() {
+    frameStart = std::chrono::steady_clock::now();
+
+    // smoothing is per primitive in its own mode only; it has no defined effect on multisample targets
+    if(antialiasingMode == AA_LINE_SMOOTH) glEnable(GL_LINE_SMOOTH);
+    else glDisable(GL_LINE_SMOOTH);
+
+    resumeAntialiasedFrame();
+    glClear(GL_COLOR_BUFFER_BIT);
+}
+
+void beginAntialiasedLayer(GLuint framebuffer) {
+    if(antialiasingMode == AA_MSAA) {
+        ensureTargets();
+        glBindFramebuffer(GL_FRAMEBUFFER, msaaFbo);
+    }
+    else {
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    }
+    glClear(GL_COLOR_BUFFER_BIT);
+}
+
+void endAntialiasedLayer(GLuint framebuffer) {
+    if(antialiasingMode == AA_MSAA) resolveMultisample(framebuffer);
+}
+
+void endAntialiasedFrame() {
+    if(antialiasingMode == AA_MSAA) {
+        resolveMultisample(0);
+    }
+    else if(antialiasingMode == AA_FXAA) {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glDisable(GL_BLEND);
+        glUseProgram(fxaaProgram);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, fxaaTexture);
+        if(uni_uScene != -1) glUniform1i(uni_uScene, 0);
+        if(uni_uInverseSize != -1) glUniform2f(uni_uInverseSize, 1.0f / targetWidth, 1.0f / targetHeight);
+        glBindVertexArray(fxaaVao);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        renderStats.drawCalls++;
+        glBindVertexArray(0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glUseProgram(0);
+        glEnable(GL_BLEND);
+    }
+
+    if(antialiasingMeasureFrames == 0) return;
+    antialiasingMeasureFrames--;
+    glFinish();
+    measuredMs[antialiasingMode] += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+    measuredFrames[antialiasingMode]++;
+}
@@ -0,0 +1,84 @@
+#include <GL/glew.h>
+#include "backgroundLayer.h"
+#include "antialiasing.h"
+#include "graphics.h"
+#include "utils.h"
+
+static GLuint layerFbo = 0, layerTexture = 0;
+static GLuint compositeProgram = 0;
+static GLuint compositeVao = 0;
+static GLint uni_uLayer = -1;
+
+// what the texture currently holds
+static uint64_t layerKey = 0;
+static int layerWidth = 0, layerHeight = 0;
+static AntialiasingMode layerMode = AA_MODE_COUNT;
+
+static const char* compositeVertexShaderSrc = R"glsl(
+#version 330 core
+void main() {
+    vec2 corner = vec2(float((gl_VertexID << 1) & 2), float(gl_VertexID & 2));
+    gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+}
+)glsl";
+
+// the layer has the window size, so pixels map one to one
+static const char* compositeFragmentShaderSrc = R"glsl(
+#version 330 core
+uniform sampler2D uLayer;
+out vec4 outColor;
+void main() {
+    outColor = texelFetch(uLayer, ivec2(gl_FragCoord.xy), 0);
+}
+)glsl";
+
+void initBackgroundLayer() {
+    compositeProgram = buildProgram(compositeVertexShaderSrc, compositeFragmentShaderSrc);
+    uni_uLayer = glGetUniformLocation(compositeProgram, "uLayer");
+    glGenVertexArrays(1, &compositeVao);
+    glGenFramebuffers(1, &layerFbo);
+    glGenTextures(1, &layerTexture);
+}
+
+bool backgroundLayerStale(uint64_t key) {
+    return key != layerKey || layerWidth != currentWindowWidth || layerHeight != currentWindowHeight
+        || layerMode != antialiasingMode;
+}
+
+void beginBackgroundLayer() {
+    if(layerWidth != currentWindowWidth || layerHeight != currentWindowHeight) {
+        layerWidth = currentWindowWidth;
+        layerHeight = currentWindowHeight;
+        glBindTexture(GL_TEXTURE_2D, layerTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, layerWidth, layerHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glBindFramebuffer(GL_FRAMEBUFFER, layerFbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, layerTexture, 0);
+    }
+    // cleared to the opaque clear color, so compositing is a plain copy
+    beginAntialiasedLayer(layerFbo);
+}
+
+void endBackgroundLayer(uint64_t key) {
+    endAntialiasedLayer(layerFbo);
+    layerKey = key;
+    layerMode = antialiasingMode;
+    resumeAntialiasedFrame();
+}
+
+void compositeBackgroundLayer() {
+    glDisable(GL_BLEND);
+    glUseProgram(compositeProgram);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, layerTexture);
+    if(uni_uLayer != -1) glUniform1i(uni_uLayer, 0);
+    glBindVertexArray(compositeVao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    renderStats.drawCalls++;
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glUseProgram(0);
+    glEnable(GL_BLEND);
+}
@@ -0,0 +1,53 @@
+#include <algorithm>
+#include "camera.h"
+#include "utils.h"
+
+Camera camera;
+
+bool ViewTransform::overlaps(double minX, double minY, double maxX, double maxY, double margin) const {
+    double hw = halfWidth() + margin, hh = halfHeight() + margin;
+    return maxX >= centerX - hw && minX <= centerX + hw && maxY >= centerY - hh && minY <= centerY + hh;
+}
+
+void ViewTransform::relativeMatrix(float m[9]) const {
+    m[0] = (float)scaleX; m[1] = 0.0f;          m[2] = 0.0f;
+    m[3] = 0.0f;          m[4] = (float)scaleY; m[5] = 0.0f;
+    m[6] = 0.0f;          m[7] = 0.0f;          m[8] = 1.0f;
+}
+
+void ViewTransform::worldMatrix(float m[9]) const {
+    relativeMatrix(m);
+    m[6] = (float)(-centerX * scaleX);
+    m[7] = (float)(-centerY * scaleY);
+}
+
+ViewTransform viewTransform(const Camera& cam, int width, int height) {
+    double worldHalfWidth = (WORLD_RIGHT - WORLD_LEFT) * 0.5;
+    double worldHalfHeight = (WORLD_TOP - WORLD_BOTTOM) * 0.5;
+    double aspectRatio = (double)width / std::max(height, 1);
+    double worldAspectRatio = worldHalfWidth / worldHalfHeight;
+    // the window side with spare room shows more of the world instead of stretching it
+    double halfWidth = worldHalfWidth, halfHeight = worldHalfHeight;
+    if(aspectRatio > worldAspectRatio) halfWidth *= aspectRatio / worldAspectRatio;
+    else halfHeight *= worldAspectRatio / aspectRatio;
+
+    ViewTransform view;
+    view.centerX = cam.centerX;
+    view.centerY = cam.centerY;
+    view.scaleX = cam.zoom / halfWidth;
+    view.scaleY = cam.zoom / halfHeight;
+    view.zoom = cam.zoom;
+    view.pixelSize = 2.0 * halfHeight / cam.zoom / std::max(height, 1);
+    return view;
+}
+
+ViewTransform currentView() {
+    return viewTransform(camera, currentWindowWidth, currentWindowHeight);
+}
+
+void screenToWorld(const ViewTransform& view, int mouseX, int mouseY, int width, int height, double& worldX, double& worldY) {
+    double ndcX = (2.0 * mouseX / width) - 1.0;
+    double ndcY = 1.0 - (2.0 * mouseY / height);
+    worldX = view.centerX + ndcX / view.scaleX;
+    worldY = view.centerY + ndcY / view.scaleY;
+}
@@ -0,0 +1,341 @@
+#include <GL/glew.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "capture.h"
+#include "pngWriter.h"
+#include "GreatCircle.h"
+#include "antialiasing.h"
+#include "pipeline.h"
+#include "scene.h"
+#include "utils.h"
+
+static const int READBACK_RING = 3;   // frames in flight: the oldest is two frames behind
+static const int MAX_QUEUED_FRAMES = 8; // encoder backlog before the render thread waits
+static const char* DEFAULT_CAPTURE_PATH = "pappus-capture.y4m";
+
+struct Readback {
+    GLuint pbo = 0;
+    GLsync fence = nullptr;
+};
+
+struct EncodedFrame {
+    std::vector<unsigned char> pixels; // RGBA, bottom row first as read from GL
+    uint64_t index = 0;
+};
+
+static Readback ring[READBACK_RING];
+static int nextSlot = 0;
+static int pendingCount = 0;
+static bool active = false;
+static bool y4mOutput = false;
+static std::string outputPath;
+static FILE* y4mFile = nullptr;
+static int captureWidth = 0, captureHeight = 0;
+static uint64_t framesRead = 0;
+
+// encoder thread and the buffers it recycles
+static std::thread encoderThread;
+static std::mutex queueMutex;
+static std::condition_variable queueChanged;
+static std::deque<EncodedFrame> encodeQueue;
+static std::vector<std::vector<unsigned char>> freeBuffers;
+static bool encoderStopping = false;
+static uint64_t framesEncoded = 0;
+static bool encoderFailed = false;
+
+// statistics
+static double issueMs = 0.0, collectMs = 0.0;
+static int fenceWaits = 0, encoderWaits = 0;
+static std::chrono::steady_clock::time_point captureStart;
+
+// sweep state
+static int sweepSteps = 0, sweepStep = 0;
+static uint64_t sweepSequence = 0;
+
+// ---- Y4M ----
+
+static bool writeY4mFrame(FILE* f, const unsigned char* rgba, int width, int height, std::vector<unsigned char>& planes) {
+    size_t plane = (size_t)width * height;
+    planes.resize(plane * 3);
+    // BT.601 studio range, rows flipped to top first
+    for(int y = 0; y < height; y++) {
+        const unsigned char* row = rgba + (size_t)(height - 1 - y) * width * 4;
+        for(int x = 0; x < width; x++) {
+            int r = row[x * 4], g = row[x * 4 + 1], b = row[x * 4 + 2];
+            size_t i = (size_t)y * width + x;
+            planes[i] = (unsigned char)((66 * r + 129 * g + 25 * b + 128) / 256 + 16);
+            planes[plane + i] = (unsigned char)((-38 * r - 74 * g + 112 * b + 128) / 256 + 128);
+            planes[2 * plane + i] = (unsigned char)((112 * r - 94 * g - 18 * b + 128) / 256 + 128);
+        }
+    }
+    fputs("FRAME\n", f);
+    return fwrite(planes.data(), 1, planes.size(), f) == planes.size();
+}
+
+static void encoderLoop() {
+    std::vector<unsigned char> planes;
+    for(;;) {
+        EncodedFrame frame;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueChanged.wait(lock, [] { return encoderStopping || !encodeQueue.empty(); });
+            if(encodeQueue.empty()) return;
+            frame = std::move(encodeQueue.front());
+            encodeQueue.pop_front();
+        }
+        bool ok;
+        if(y4mOutput) {
+            ok = writeY4mFrame(y4mFile, frame.pixels.data(), captureWidth, captureHeight, planes);
+        }
+        else {
+            char name[64];
+            snprintf(name, sizeof name, "_%06llu.png", (unsigned long long)frame.index);
+            ok = writePng((outputPath + name).c_str(), frame.pixels.data(), captureWidth, captureHeight);
+        }
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            if(!ok) encoderFailed = true;
+            framesEncoded++;
+            freeBuffers.push_back(std::move(frame.pixels));
+        }
+        queueChanged.notify_all();
+    }
+}
+
+static void stopEncoder() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        encoderStopping = true;
+    }
+    queueChanged.notify_all();
+    if(encoderThread.joinable()) encoderThread.join();
+}
+
+// ---- readback ring ----
+
+// map the oldest readback and hand its pixels to the encoder
+static void collectOldest() {
+    Readback& slot = ring[(nextSlot - pendingCount + READBACK_RING) % READBACK_RING];
+    auto start = std::chrono::steady_clock::now();
+    if(glClientWaitSync(slot.fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+        fenceWaits++;
+        while(glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED) {}
+    }
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+
+    std::vector<unsigned char> pixels;
+    {
+        std::unique_lock<std::mutex> lock(queueMutex);
+        if(freeBuffers.empty() && encodeQueue.size() >= MAX_QUEUED_FRAMES) {
+            encoderWaits++;
+            queueChanged.wait(lock, [] { return !freeBuffers.empty(); });
+        }
+        if(!freeBuffers.empty()) {
+            pixels = std::move(freeBuffers.back());
+            freeBuffers.pop_back();
+        }
+    }
+    size_t bytes = (size_t)captureWidth * captureHeight * 4;
+    pixels.resize(bytes);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT);
+    if(mapped) memcpy(pixels.data(), mapped, bytes);
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    pendingCount--;
+
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        encodeQueue.push_back({std::move(pixels), framesRead - pendingCount - 1});
+    }
+    queueChanged.notify_all();
+    collectMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool startCapture(const char* path) {
+    if(active) stopCapture();
+    outputPath = path;
+    y4mOutput = outputPath.size() >= 4 && outputPath.compare(outputPath.size() - 4, 4, ".y4m") == 0;
+    captureWidth = currentWindowWidth;
+    captureHeight = currentWindowHeight;
+    if(y4mOutput) {
+        y4mFile = fopen(path, "wb");
+        if(!y4mFile) {
+            fprintf(stderr, "Cannot write capture to %s\n", path);
+            return false;
+        }
+        fprintf(y4mFile, "YUV4MPEG2 W%d H%d F60:1 Ip A1:1 C444\n", captureWidth, captureHeight);
+    }
+
+    size_t bytes = (size_t)captureWidth * captureHeight * 4;
+    for(Readback& slot : ring) {
+        if(slot.pbo == 0) glGenBuffers(1, &slot.pbo);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    nextSlot = pendingCount = 0;
+    framesRead = framesEncoded = 0;
+    issueMs = collectMs = 0.0;
+    fenceWaits = encoderWaits = 0;
+    encoderStopping = encoderFailed = false;
+    encodeQueue.clear();
+    encoderThread = std::thread(encoderLoop);
+    static bool exitHookRegistered = false;
+    if(!exitHookRegistered) {
+        atexit(stopEncoder);
+        exitHookRegistered = true;
+    }
+    // a measurement window still open would drain the GPU every frame
+    antialiasingMeasureFrames = 0;
+    active = true;
+    captureStart = std::chrono::steady_clock::now();
+    printf("capture: recording %dx%d to %s%s\n", captureWidth, captureHeight, path, y4mOutput ? "" : "_NNNNNN.png");
+    return true;
+}
+
+void stopCapture() {
+    if(!active) return;
+    while(pendingCount > 0) collectOldest();
+    stopEncoder();
+    if(y4mFile) {
+        if(fclose(y4mFile) != 0) encoderFailed = true;
+        y4mFile = nullptr;
+    }
+    active = false;
+    sweepSteps = 0;
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - captureStart).count();
+    printf("capture: %llu frames in %.2f s (%.1f fps); render thread per frame: readback %.3f ms, collect %.3f ms; "
+           "fence waits %d, encoder waits %d%s\n",
+           (unsigned long long)framesEncoded, seconds, seconds > 0 ? framesEncoded / seconds : 0.0,
+           framesRead ? issueMs / framesRead : 0.0, framesRead ? collectMs / framesRead : 0.0,
+           fenceWaits, encoderWaits, encoderFailed ? "; WRITE ERRORS" : "");
+}
+
+bool capturing() {
+    return active;
+}
+
+void toggleCapture() {
+    if(active) stopCapture();
+    else startCapture(DEFAULT_CAPTURE_PATH);
+}
+
+// place the interactive point for the current sweep step and publish it
+static void publishSweepStep() {
+    GreatCircle line = isIdealLine[0] ? GreatCircle(Vector3(0, 0, 1)) : baseLines[0];
+    // open interval, the ends are the point at infinity
+    double t = M_PI * (sweepStep + 0.5) / sweepSteps;
+    Vector3 point = (line.u() * std::cos(t) + line.v() * std::sin(t)) * circleRadius;
+    interactivePoint = std::make_tuple(point[0], point[1]);
+    canDrawInteractivePoint = true;
+    publishInput();
+    sweepSequence = latestInputSequence();
+}
+
+void startCaptureSweep(int steps) {
+    if(collectedPoints < 6) {
+        fprintf(stderr, "capture sweep needs the six points of the configuration\n");
+        return;
+    }
+    if(!active && !startCapture(DEFAULT_CAPTURE_PATH)) return;
+    sweepSteps = std::max(steps, 1);
+    sweepStep = 0;
+    publishSweepStep();
+}
+
+void captureFrame(uint64_t inputSequence) {
+    if(!active) return;
+    bool sweeping = sweepSteps > 0;
+    if(sweeping && inputSequence < sweepSequence) return; // the step's scene is not built yet
+    if(currentWindowWidth != captureWidth || currentWindowHeight != captureHeight) {
+        fprintf(stderr, "capture: window resized, stopping\n");
+        stopCapture();
+        return;
+    }
+
+    // reuse the slot of the oldest readback once it has been collected
+    if(pendingCount == READBACK_RING) collectOldest();
+    auto start = std::chrono::steady_clock::now();
+    Readback& slot = ring[nextSlot];
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, captureWidth, captureHeight, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    nextSlot = (nextSlot + 1) % READBACK_RING;
+    pendingCount++;
+    framesRead++;
+    issueMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    if(sweeping) {
+        if(++sweepStep < sweepSteps) publishSweepStep();
+        else stopCapture();
+    }
+}
+
+int runOffscreenCapture(FILE* in, const char* path, int width, int height) {
+    double values[SCENE_RECORD_VALUES];
+    if(readSceneRecord(in, values) < 12) {
+        fprintf(stderr, "capture: expected a record x1 y1 x2 y2 x3 y3 u1 v1 u2 v2 u3 v3 on the input\n");
+        return 1;
+    }
+    GreatCircle line = GreatCircle::through(liftToSphere(values[0], values[1], circleRadius),
+                                            liftToSphere(values[2], values[3], circleRadius));
+
+    GLuint fbo, colorBuffer;
+    glGenFramebuffers(1, &fbo);
+    glGenRenderbuffers(1, &colorBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    // the capture takes its size from the window and reads the bound framebuffer
+    currentWindowWidth = width;
+    currentWindowHeight = height;
+    if(!complete || !startCapture(path)) {
+        if(!complete) fprintf(stderr, "capture: cannot create a %dx%d offscreen target\n", width, height);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glDeleteRenderbuffers(1, &colorBuffer);
+        glDeleteFramebuffers(1, &fbo);
+        return 1;
+    }
+    glViewport(0, 0, width, height);
+    glEnable(GL_LINE_SMOOTH);
+
+    // the steps of startCaptureSweep, each frame built and drawn right away
+    static FrameGeometry background, foreground;
+    for(int step = 0; step < CAPTURE_SWEEP_STEPS; step++) {
+        double t = M_PI * (step + 0.5) / CAPTURE_SWEEP_STEPS;
+        Vector3 point = (line.u() * std::cos(t) + line.v() * std::sin(t)) * circleRadius;
+        values[12] = point[0];
+        values[13] = point[1];
+        buildRecordScene(values, SCENE_RECORD_VALUES, width, height, background, foreground);
+        glClear(GL_COLOR_BUFFER_BIT);
+        background.submit();
+        foreground.submit();
+        captureFrame(step + 1);
+    }
+    stopCapture();
+    bool failed = encoderFailed;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteRenderbuffers(1, &colorBuffer);
+    glDeleteFramebuffers(1, &fbo);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,291 @@
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <sys/stat.h>
+#include <vector>
+#include "computeServer.h"
+#include "pappus.h"
+#include "utils.h"
+#include "TaskPool.h"
+#include "Dataset.h"
+
+static const size_t BLOCK_BYTES = 256 * 1024;
+static const int MAX_QUERY_POINTS = 64;
+static const int OUTPUT_PRECISION = 12;
+
+// one block of whole lines and the text produced for it; buffers are reused between windows
+struct ServerBlock {
+    std::vector<char> input;
+    std::vector<char> output;
+    // packing mode keeps the parsed points instead of formatting results
+    bool packing = false;
+    std::vector<ConfigurationRecord> configurations;
+    size_t records = 0;
+    size_t errors = 0;
+};
+
+// fill the block with whole lines, keeping a trailing partial line in carry; false at end of input
+static bool readBlock(FILE* in, std::vector<char>& carry, ServerBlock& block) {
+    block.input.assign(carry.begin(), carry.end());
+    carry.clear();
+    for(;;) {
+        size_t old = block.input.size();
+        block.input.resize(old + BLOCK_BYTES);
+        size_t got = fread(block.input.data() + old, 1, BLOCK_BYTES, in);
+        block.input.resize(old + got);
+        if(got == 0) {
+            if(block.input.empty()) return false;
+            if(block.input.back() != '\n') block.input.push_back('\n');
+            return true;
+        }
+        // a single line longer than a block keeps reading
+        for(size_t i = block.input.size(); i > old; i--) {
+            if(block.input[i - 1] == '\n') {
+                carry.assign(block.input.begin() + i, block.input.end());
+                block.input.resize(i);
+                return true;
+            }
+        }
+    }
+}
+
+static void appendText(std::vector<char>& out, const char* text) {
+    out.insert(out.end(), text, text + strlen(text));
+}
+
+static void appendNumber(std::vector<char>& out, double value, bool first = false) {
+    char buffer[32];
+    char* cursor = buffer;
+    if(!first) *cursor++ = ' ';
+    cursor = std::to_chars(cursor, buffer + sizeof(buffer), value, std::chars_format::general, OUTPUT_PRECISION).ptr;
+    out.insert(out.end(), buffer, cursor);
+}
+
+// numbers of one line; 0 for blank and comment lines, -1 with reason set when malformed
+static int parseRecord(const char* cursor, const char* end, double* values, const char*& reason) {
+    int count = 0;
+    for(;;) {
+        while(cursor < end && (*cursor == ' ' || *cursor == '\t' || *cursor == '\r' || *cursor == ',')) cursor++;
+        if(cursor == end) break;
+        if(count == 0 && *cursor == '#') return 0;
+        if(count == 12 + 2 * MAX_QUERY_POINTS) {
+            reason = "too many query points";
+            return -1;
+        }
+        auto [next, status] = std::from_chars(cursor, end, values[count]);
+        if(status != std::errc()) {
+            reason = "malformed number";
+            return -1;
+        }
+        cursor = next;
+        count++;
+    }
+    if(count != 0 && (count < 12 || count % 2 != 0)) {
+        reason = "expected six points and query point pairs";
+        return -1;
+    }
+    return count;
+}
+
+// same lifting the interactive scene applies to the marked points
+static void liftTriples(const double* values, Vector3 xs[3], Vector3 ys[3]) {
+    for(int k = 0; k < 6; k++) {
+        double px = values[2 * k], py = values[2 * k + 1];
+        capDistance2D(px, py);
+        (k < 3 ? xs[k] : ys[k - 3]) = liftToSphere(px, py, circleRadius);
+    }
+}
+
+static void processRecord(const char* begin, const char* end, ServerBlock& block) {
+    double values[12 + 2 * MAX_QUERY_POINTS];
+    const char* reason = nullptr;
+    int count = parseRecord(begin, end, values, reason);
+    if(count == 0) return;
+    block.records++;
+    if(count < 0) {
+        appendText(block.output, "error ");
+        appendText(block.output, reason);
+        block.output.push_back('\n');
+        block.errors++;
+        return;
+    }
+
+    if(block.packing) {
+        ConfigurationRecord record;
+        memcpy(record.points, values, sizeof(record.points));
+        block.configurations.push_back(record);
+        return;
+    }
+
+    Vector3 xs[3], ys[3];
+    liftTriples(values, xs, ys);
+    PappusConfiguration config = computePappus(xs, ys);
+
+    for(int i = 0; i < 3; i++) {
+        Vector3 intersection = config.intersections[i];
+        if(intersection[2] < 0) intersection = intersection * -1;
+        appendNumber(block.output, intersection[0], i == 0);
+        appendNumber(block.output, intersection[1]);
+    }
+    Vector3 axis = config.axis.normalize();
+    if(axis[2] < 0) axis = axis * -1;
+    appendNumber(block.output, axis[0]);
+    appendNumber(block.output, axis[1]);
+    appendNumber(block.output, axis[2]);
+
+    for(int q = 12; q < count; q += 2) {
+        double px = values[q], py = values[q + 1];
+        capDistance2D(px, py);
+        PappusImage image = pappusImage(config, liftToSphere(px, py, circleRadius));
+        appendNumber(block.output, image.image[0]);
+        appendNumber(block.output, image.image[1]);
+    }
+    block.output.push_back('\n');
+}
+
+static void processBlock(ServerBlock& block) {
+    block.output.clear();
+    block.configurations.clear();
+    block.records = 0;
+    block.errors = 0;
+    const char* cursor = block.input.data();
+    const char* end = cursor + block.input.size();
+    while(cursor < end) {
+        const char* lineEnd = (const char*)memchr(cursor, '\n', end - cursor);
+        processRecord(cursor, lineEnd, block);
+        cursor = lineEnd + 1;
+    }
+}
+
+// read, process and emit the input a window of blocks at a time; packing sends the parsed
+// configurations to the dataset writer and only error lines to out
+static int streamBlocks(FILE* in, FILE* out, DatasetWriter* pack) {
+    auto start = std::chrono::steady_clock::now();
+    TaskPool& pool = TaskPool::shared();
+    // a couple of blocks per thread keeps every worker busy while bounding what is held in memory
+    std::vector<ServerBlock> window(pool.size() * 2);
+    for(ServerBlock& block : window) block.packing = pack != nullptr;
+    std::vector<char> carry;
+    size_t records = 0, errors = 0;
+
+    bool more = true;
+    while(more) {
+        size_t filled = 0;
+        while(filled < window.size() && (more = readBlock(in, carry, window[filled]))) filled++;
+        if(filled == 0) break;
+
+        pool.parallelFor(filled, [&](size_t b) {
+            processBlock(window[b]);
+        });
+
+        for(size_t b = 0; b < filled; b++) {
+            const ServerBlock& block = window[b];
+            if(fwrite(block.output.data(), 1, block.output.size(), out) != block.output.size()) {
+                fprintf(stderr, "compute server: write failed\n");
+                return 1;
+            }
+            if(pack && !pack->append(block.configurations.data(), block.configurations.size())) {
+                fprintf(stderr, "compute server: %s\n", pack->error().c_str());
+                return 1;
+            }
+            records += block.records;
+            errors += block.errors;
+        }
+    }
+    fflush(out);
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    fprintf(stderr, "compute server: %zu records (%zu errors) in %.3f s, %.0f records/s\n",
+            records, errors, seconds, seconds > 0 ? records / seconds : 0.0);
+    return ferror(in) ? 1 : 0;
+}
+
+int runComputeServer(FILE* in, FILE* out) {
+    return streamBlocks(in, out, nullptr);
+}
+
+int runDatasetPack(FILE* in, const char* configurationPath) {
+    DatasetWriter writer;
+    if(!writer.open(configurationPath, DATASET_CONFIGURATIONS, sizeof(ConfigurationRecord))) {
+        fprintf(stderr, "compute server: %s\n", writer.error().c_str());
+        return 1;
+    }
+    int status = streamBlocks(in, stdout, &writer);
+    if(!writer.close()) {
+        fprintf(stderr, "compute server: %s\n", writer.error().c_str());
+        return 1;
+    }
+    return status;
+}
+
+static void computeResult(const ConfigurationRecord& configuration, ResultRecord& result) {
+    Vector3 xs[3], ys[3];
+    liftTriples(&configuration.points[0][0], xs, ys);
+    PappusConfiguration config = computePappus(xs, ys);
+    for(int i = 0; i < 3; i++) {
+        Vector3 intersection = config.intersections[i];
+        if(intersection[2] < 0) intersection = intersection * -1;
+        for(int c = 0; c < 3; c++) result.intersections[i][c] = intersection[c];
+    }
+    Vector3 axis = config.axis.normalize();
+    if(axis[2] < 0) axis = axis * -1;
+    for(int c = 0; c < 3; c++) result.axis[c] = axis[c];
+    result.residual = pappusResidual(config);
+    result.flags = checkLinePointsDifferent(config.chosen1, config.chosen2) ? 0 : RESULT_DEGENERATE;
+    result.reserved = 0;
+}
+
+int runDatasetCompute(const char* configurationPath, const char* resultPath, int shard, int shardCount) {
+    auto start = std::chrono::steady_clock::now();
+    struct stat info;
+    if(stat(configurationPath, &info) != 0) {
+        perror(configurationPath);
+        return 1;
+    }
+    // shards split the file by bytes; each record belongs to the shard holding its first byte
+    uint64_t fileBytes = (uint64_t)info.st_size;
+    uint64_t byteBegin = fileBytes * shard / shardCount;
+    uint64_t byteEnd = fileBytes * (shard + 1) / shardCount;
+    if(shard == shardCount - 1) byteEnd = UINT64_MAX;
+
+    DatasetReader reader;
+    if(!reader.open(configurationPath, DATASET_CONFIGURATIONS, byteBegin, byteEnd)) {
+        fprintf(stderr, "compute server: %s\n", reader.error().c_str());
+        return 1;
+    }
+    DatasetWriter writer;
+    if(!writer.open(resultPath, DATASET_RESULTS, sizeof(ResultRecord))) {
+        fprintf(stderr, "compute server: %s\n", writer.error().c_str());
+        return 1;
+    }
+
+    // records are read straight from the mapping; results are staged one slice at a time
+    const size_t SLICE_RECORDS = 64 * 1024;
+    const size_t TASK_RECORDS = 1024;
+    std::vector<ResultRecord> results(SLICE_RECORDS);
+    const ConfigurationRecord* configurations = reader.records<ConfigurationRecord>();
+    for(size_t sliceBegin = 0; sliceBegin < reader.size(); sliceBegin += SLICE_RECORDS) {
+        size_t sliceCount = std::min(SLICE_RECORDS, reader.size() - sliceBegin);
+        TaskPool::shared().parallelFor((sliceCount + TASK_RECORDS - 1) / TASK_RECORDS, [&](size_t task) {
+            size_t end = std::min(sliceCount, (task + 1) * TASK_RECORDS);
+            for(size_t i = task * TASK_RECORDS; i < end; i++) {
+                computeResult(configurations[sliceBegin + i], results[i]);
+            }
+        });
+        if(!writer.append(results.data(), sliceCount)) {
+            fprintf(stderr, "compute server: %s\n", writer.error().c_str());
+            return 1;
+        }
+    }
+    if(!writer.close()) {
+        fprintf(stderr, "compute server: %s\n", writer.error().c_str());
+        return 1;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    fprintf(stderr, "compute server: shard %d/%d, records %zu..%zu, %.3f s, %.0f records/s\n",
+            shard, shardCount, reader.firstIndex(), reader.firstIndex() + reader.size(), seconds,
+            seconds > 0 ? reader.size() / seconds : 0.0);
+    return 0;
+}
@@ -0,0 +1,121 @@
+#include <GL/glew.h>
+#include <cmath>
+#include "conics.h"
+#include "graphics.h"
+#include "utils.h"
+
+bool useAnalyticConics = false;
+
+static GLuint conicProgram = 0;
+static GLuint conicVao = 0, conicUbo = 0;
+static GLint uni_uDiskCenter = -1;
+static GLint uni_uDiskHalfSize = -1;
+static GLint uni_uConicCount = -1;
+static GLint uni_uConicView = -1;
+
+// quad around the disk, corners generated from gl_VertexID so no vertex buffer is needed;
+// the disk center arrives relative to the camera
+static const char* conicVertexShaderSrc = R"glsl(
+#version 330 core
+uniform vec2 uDiskCenter;
+uniform float uDiskHalfSize;
+uniform mat3 uView;
+out vec2 localPos;
+void main() {
+    vec2 corner = vec2(float(gl_VertexID & 1), float((gl_VertexID >> 1) & 1)) * 2.0 - 1.0;
+    localPos = corner * uDiskHalfSize;
+    vec2 relativePos = uDiskCenter + localPos;
+    gl_Position = vec4((uView * vec3(relativePos, 1.0)).xy, 0.0, 1.0);
+}
+)glsl";
+
+// per fragment distance to every conic of the disk, composited in submission order
+static const char* conicFragmentShaderSrc = R"glsl(
+#version 330 core
+#define MAX_CONICS 64
+layout(std140) uniform ConicBlock {
+    vec4 uAxes[MAX_CONICS];
+    vec4 uCenterFlags[MAX_CONICS];
+    vec4 uColors[MAX_CONICS];
+};
+uniform int uConicCount;
+in vec2 localPos;
+out vec4 outColor;
+void main() {
+    // world units covered by one pixel, keeps curves one pixel wide at any size
+    float pixelSize = max(length(vec2(dFdx(localPos.x), dFdy(localPos.x))), 1e-6);
+    vec3 accColor = vec3(0.0);
+    float accAlpha = 0.0;
+    for(int i = 0; i < uConicCount; i++) {
+        vec2 col0 = uAxes[i].xy;
+        vec2 col1 = uAxes[i].zw;
+        vec2 p = localPos - uCenterFlags[i].xy;
+        // implicit form |adj(A) p| - |det A| stays well defined when the ellipse collapses to a segment
+        float det = col0.x * col1.y - col1.x * col0.y;
+        vec2 q = vec2(col1.y * p.x - col1.x * p.y, -col0.y * p.x + col0.x * p.y);
+        float qLen = max(length(q), 1e-9);
+        float g = qLen - abs(det);
+        vec2 grad = vec2(col1.y * q.x - col0.y * q.y, -col1.x * q.x + col0.x * q.y) / qLen;
+        float dist = abs(g) / max(length(grad), 1e-9);
+        float coverage = clamp(1.0 - dist / pixelSize, 0.0, 1.0);
+        if(uCenterFlags[i].z < 0.5) {
+            // keep only t in [0, PI]: the side of col0 that col1 points to
+            vec2 halfDir = normalize(vec2(-col0.y, col0.x));
+            if(dot(col1, halfDir) < 0.0) halfDir = -halfDir;
+            coverage *= smoothstep(-pixelSize, 0.0, dot(p, halfDir));
+        }
+        accColor = uColors[i].rgb * coverage + accColor * (1.0 - coverage);
+        accAlpha = coverage + accAlpha * (1.0 - coverage);
+    }
+    if(accAlpha <= 0.0) discard;
+    outColor = vec4(accColor / accAlpha, accAlpha);
+}
+)glsl";
+
+void initConicResources() {
+    conicProgram = buildProgram(conicVertexShaderSrc, conicFragmentShaderSrc);
+    uni_uDiskCenter = glGetUniformLocation(conicProgram, "uDiskCenter");
+    uni_uDiskHalfSize = glGetUniformLocation(conicProgram, "uDiskHalfSize");
+    uni_uConicCount = glGetUniformLocation(conicProgram, "uConicCount");
+    uni_uConicView = glGetUniformLocation(conicProgram, "uView");
+    GLuint blockIndex = glGetUniformBlockIndex(conicProgram, "ConicBlock");
+    if(blockIndex != GL_INVALID_INDEX) glUniformBlockBinding(conicProgram, blockIndex, 0);
+
+    glGenVertexArrays(1, &conicVao);
+    glGenBuffers(1, &conicUbo);
+    glBindBuffer(GL_UNIFORM_BUFFER, conicUbo);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(ConicBlock), nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void drawConics(const ConicSet& conics, const ViewTransform& view) {
+    if(conics.diskCount == 0) return;
+    glUseProgram(conicProgram);
+    glBindVertexArray(conicVao);
+    glBindBufferBase(GL_UNIFORM_BUFFER, 0, conicUbo);
+    if(uni_uConicView != -1) {
+        float m[9];
+        view.relativeMatrix(m);
+        glUniformMatrix3fv(uni_uConicView, 1, GL_FALSE, m);
+    }
+    // markers of antipodal points sit slightly outside the disk
+    float halfSize = circleRadius + 16.0f;
+    if(uni_uDiskHalfSize != -1) glUniform1f(uni_uDiskHalfSize, halfSize);
+
+    for(int d = 0; d < conics.diskCount; d++) {
+        const ConicDisk& disk = conics.disks[d];
+        if(disk.count == 0) continue;
+        // a disk outside the view costs a full quad of fragments for nothing
+        if(!view.overlaps(disk.offsetX - halfSize, disk.offsetY - halfSize, disk.offsetX + halfSize, disk.offsetY + halfSize)) continue;
+        glBindBuffer(GL_UNIFORM_BUFFER, conicUbo);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(ConicBlock), &disk.block);
+        if(uni_uDiskCenter != -1) glUniform2f(uni_uDiskCenter, (float)(disk.offsetX - view.centerX), (float)(disk.offsetY - view.centerY));
+        if(uni_uConicCount != -1) glUniform1i(uni_uConicCount, disk.count);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        renderStats.drawCalls++;
+    }
+
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindVertexArray(0);
+    glUseProgram(0);
+}
@@ -0,0 +1,185 @@
+#include <GL/glew.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "correspondenceMap.h"
+#include "GreatCircle.h"
+#include "TaskPool.h"
+#include "graphics.h"
+#include "utils.h"
+
+static const size_t CPU_TASK_POINTS = 4096;
+static const size_t GPU_CHUNK_POINTS = 1 << 20; // per draw; two chunks are in flight
+
+static GLuint mapProgram = 0;
+static GLuint mapVao = 0;
+static GLuint pointBuffers[2] = {}, imageBuffers[2] = {};
+static GLint uni_uCenter1 = -1, uni_uCenter2 = -1, uni_uAxis = -1, uni_uImageLine = -1;
+
+// the chain of pappusImage on the unit sphere; the caller scales by the radius
+static const char* mapVertexShaderSrc = R"glsl(
+#version 330 core
+layout(location = 0) in vec2 aPoint;
+uniform vec3 uCenter1;
+uniform vec3 uCenter2;
+uniform vec3 uAxis;
+uniform vec3 uImageLine;
+uniform float uRadius;
+out vec3 vImage;
+void main() {
+    vec2 q = aPoint / uRadius;
+    vec3 point = vec3(q, sqrt(max(1.0 - dot(q, q), 0.0)));
+    vec3 axisPoint = normalize(cross(uAxis, cross(uCenter1, point)));
+    vec3 image = normalize(cross(uImageLine, cross(uCenter2, axisPoint)));
+    vImage = (image.z < 0.0 ? -image : image) * uRadius;
+}
+)glsl";
+
+void mapPointsCpu(const PappusConfiguration& config, const float* points, size_t count, float* images) {
+    TaskPool::shared().parallelFor((count + CPU_TASK_POINTS - 1) / CPU_TASK_POINTS, [&](size_t task) {
+        size_t end = std::min(count, (task + 1) * CPU_TASK_POINTS);
+        for(size_t i = task * CPU_TASK_POINTS; i < end; i++) {
+            Vector3 point = liftToSphere(points[2 * i], points[2 * i + 1], circleRadius);
+            Vector3 image = pappusImage(config, point).image;
+            images[3 * i] = (float)image[0];
+            images[3 * i + 1] = (float)image[1];
+            images[3 * i + 2] = (float)image[2];
+        }
+    });
+}
+
+// the captured varying has to be declared before linking, so buildProgram (and its cache) is not used
+static void initCorrespondenceMapResources() {
+    if(mapProgram != 0) return;
+    GLuint vs = compileShader(GL_VERTEX_SHADER, mapVertexShaderSrc);
+    mapProgram = glCreateProgram();
+    glAttachShader(mapProgram, vs);
+    const char* varyings[] = {"vImage"};
+    glTransformFeedbackVaryings(mapProgram, 1, varyings, GL_INTERLEAVED_ATTRIBS);
+    glLinkProgram(mapProgram);
+    GLint ok;
+    glGetProgramiv(mapProgram, GL_LINK_STATUS, &ok);
+    if(!ok) {
+        char buf[1024];
+        glGetProgramInfoLog(mapProgram, 1024, nullptr, buf);
+        std::cerr << "Program link error: " << buf << std::endl;
+    }
+    glDeleteShader(vs);
+    uni_uCenter1 = glGetUniformLocation(mapProgram, "uCenter1");
+    uni_uCenter2 = glGetUniformLocation(mapProgram, "uCenter2");
+    uni_uAxis = glGetUniformLocation(mapProgram, "uAxis");
+    uni_uImageLine = glGetUniformLocation(mapProgram, "uImageLine");
+
+    glGenVertexArrays(1, &mapVao);
+    glGenBuffers(2, pointBuffers);
+    glGenBuffers(2, imageBuffers);
+    glBindVertexArray(mapVao);
+    for(int k = 0; k < 2; k++) {
+        glBindBuffer(GL_ARRAY_BUFFER, pointBuffers[k]);
+        glBufferData(GL_ARRAY_BUFFER, GPU_CHUNK_POINTS * 2 * sizeof(float), nullptr, GL_STREAM_DRAW);
+        glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, imageBuffers[k]);
+        glBufferData(GL_TRANSFORM_FEEDBACK_BUFFER, GPU_CHUNK_POINTS * 3 * sizeof(float), nullptr, GL_STREAM_READ);
+    }
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, 0);
+}
+
+static void setUnitUniform(GLint location, const Vector3& v) {
+    Vector3 unit = v.normalize();
+    if(location != -1) glUniform3f(location, (float)unit[0], (float)unit[1], (float)unit[2]);
+}
+
+void mapPointsGpu(const PappusConfiguration& config, const float* points, size_t count, float* images) {
+    initCorrespondenceMapResources();
+    // the point-independent part of pappusImage is evaluated once here
+    PappusImage constants = pappusImage(config, config.x[0]);
+    glUseProgram(mapProgram);
+    setUnitUniform(uni_uCenter1, constants.center1);
+    setUnitUniform(uni_uCenter2, constants.center2);
+    setUnitUniform(uni_uAxis, config.axis);
+    setUnitUniform(uni_uImageLine, config.y[1].cross(config.y[2]));
+    glUniform1f(glGetUniformLocation(mapProgram, "uRadius"), (float)circleRadius);
+    glBindVertexArray(mapVao);
+    glEnable(GL_RASTERIZER_DISCARD);
+
+    // chunk k is drawn while chunk k - 1 is read back, so the readback waits only for its own draw
+    size_t chunks = (count + GPU_CHUNK_POINTS - 1) / GPU_CHUNK_POINTS;
+    for(size_t k = 0; k <= chunks; k++) {
+        if(k < chunks) {
+            size_t first = k * GPU_CHUNK_POINTS;
+            size_t n = std::min(GPU_CHUNK_POINTS, count - first);
+            glBindBuffer(GL_ARRAY_BUFFER, pointBuffers[k % 2]);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, n * 2 * sizeof(float), points + 2 * first);
+            glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, (void*)0);
+            glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, imageBuffers[k % 2]);
+            glBeginTransformFeedback(GL_POINTS);
+            glDrawArrays(GL_POINTS, 0, (GLsizei)n);
+            glEndTransformFeedback();
+        }
+        if(k > 0) {
+            size_t first = (k - 1) * GPU_CHUNK_POINTS;
+            size_t n = std::min(GPU_CHUNK_POINTS, count - first);
+            glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, imageBuffers[(k - 1) % 2]);
+            glGetBufferSubData(GL_TRANSFORM_FEEDBACK_BUFFER, 0, n * 3 * sizeof(float), images + 3 * first);
+        }
+    }
+
+    glDisable(GL_RASTERIZER_DISCARD);
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+    glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+    glUseProgram(0);
+}
+
+void runCorrespondenceBenchmark(size_t count) {
+    // two well separated lines, each with three points, as a user would mark them
+    Vector3 xs[3], ys[3];
+    GreatCircle line1 = GreatCircle::through(liftToSphere(50, 30, circleRadius), liftToSphere(-80, 60, circleRadius));
+    GreatCircle line2 = GreatCircle::through(liftToSphere(40, -70, circleRadius), liftToSphere(-20, 90, circleRadius));
+    const double ts[3] = {0.7, 1.4, 2.2};
+    for(int i = 0; i < 3; i++) {
+        xs[i] = (line1.u() * std::cos(ts[i]) + line1.v() * std::sin(ts[i])) * circleRadius;
+        ys[i] = (line2.u() * std::cos(ts[i] + 0.3) + line2.v() * std::sin(ts[i] + 0.3)) * circleRadius;
+    }
+    PappusConfiguration config = computePappus(xs, ys);
+
+    std::vector<float> points(count * 2);
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> angle(0.01, M_PI - 0.01);
+    for(size_t i = 0; i < count; i++) {
+        double t = angle(rng);
+        Vector3 p = (line1.u() * std::cos(t) + line1.v() * std::sin(t)) * circleRadius;
+        points[2 * i] = (float)p[0];
+        points[2 * i + 1] = (float)p[1];
+    }
+    std::vector<float> cpuImages(count * 3), gpuImages(count * 3);
+
+    auto seconds = [](std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+    auto start = std::chrono::steady_clock::now();
+    mapPointsCpu(config, points.data(), count, cpuImages.data());
+    double cpuSeconds = seconds(start);
+
+    // the first call compiles the program; warm up on a small batch so it is not timed
+    mapPointsGpu(config, points.data(), std::min<size_t>(count, 1024), gpuImages.data());
+    start = std::chrono::steady_clock::now();
+    mapPointsGpu(config, points.data(), count, gpuImages.data());
+    double gpuSeconds = seconds(start);
+
+    double worst = 0.0;
+    for(size_t i = 0; i < count * 3; i++) worst = std::max(worst, (double)std::abs(cpuImages[i] - gpuImages[i]));
+    printf("correspondence map, %zu points\n", count);
+    printf("  cpu (%u threads, double): %8.2f ms  %8.2f Mpoints/s\n", TaskPool::shared().size(),
+           cpuSeconds * 1e3, count / cpuSeconds / 1e6);
+    printf("  gpu (transform feedback): %8.2f ms  %8.2f Mpoints/s (upload and readback included)\n",
+           gpuSeconds * 1e3, count / gpuSeconds / 1e6);
+    printf("  largest deviation from the reference: %.3g (radius %d)\n", worst, circleRadius);
+}
@@ -0,0 +1,270 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include "cpuRasterizer.h"
+#include "scene.h"
+#include "pngWriter.h"
+#include "utils.h"
+
+// line width and point size of the GL path, in pixels
+static const float LINE_HALF_WIDTH = 0.5f;
+static const float POINT_HALF_WIDTH = 2.75f;
+// primitives per binning job
+static const size_t BIN_CHUNK_PRIMITIVES = 4096;
+
+// four horizontally adjacent pixels
+typedef float Pixels __attribute__((vector_size(4 * sizeof(float))));
+static const Pixels LANE_OFFSETS = {0.5f, 1.5f, 2.5f, 3.5f};
+
+static double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+CpuRasterizer::CpuRasterizer(int width, int height, TaskPool& pool)
+    : pool(pool), targetWidth(width), targetHeight(height),
+      tilesX((width + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE),
+      tilesY((height + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE),
+      framebuffer((size_t)width * height * 4, 0) {
+}
+
+void CpuRasterizer::clear(float r, float g, float b) {
+    primitives.clear();
+    unsigned char rgba[4] = {(unsigned char)std::lround(r * 255), (unsigned char)std::lround(g * 255),
+                             (unsigned char)std::lround(b * 255), 255};
+    for(size_t i = 0; i < framebuffer.size(); i += 4) memcpy(&framebuffer[i], rgba, 4);
+}
+
+void CpuRasterizer::addSegment(float x0, float y0, float x1, float y1, float halfWidth, const float color[3]) {
+    // nothing of it reaches the framebuffer
+    float reach = halfWidth + 1.0f;
+    if(std::max(x0, x1) + reach < 0 || std::min(x0, x1) - reach > targetWidth) return;
+    if(std::max(y0, y1) + reach < 0 || std::min(y0, y1) - reach > targetHeight) return;
+    primitives.push_back({x0, y0, x1, y1, halfWidth, {color[0], color[1], color[2]}});
+}
+
+void CpuRasterizer::drawVertices(const float* data, size_t floatCount, PrimitiveMode mode, const ViewTransform& view) {
+    size_t count = floatCount / 5;
+    if(count == 0) return;
+    // window pixels, origin at the bottom left as in GL
+    double halfW = targetWidth * 0.5, halfH = targetHeight * 0.5;
+    auto screenX = [&](size_t i) { return (float)(((data[5 * i] - view.centerX) * view.scaleX + 1.0) * halfW); };
+    auto screenY = [&](size_t i) { return (float)(((data[5 * i + 1] - view.centerY) * view.scaleY + 1.0) * halfH); };
+    // GL takes the provoking (last) vertex color for flat lines; the shader interpolates, which
+    // for these single-colored strips is the same
+    auto segment = [&](size_t a, size_t b) {
+        addSegment(screenX(a), screenY(a), screenX(b), screenY(b), LINE_HALF_WIDTH, data + 5 * b + 2);
+    };
+    switch(mode) {
+        case PRIMITIVE_POINTS:
+            for(size_t i = 0; i < count; i++) addSegment(screenX(i), screenY(i), screenX(i), screenY(i), POINT_HALF_WIDTH, data + 5 * i + 2);
+            break;
+        case PRIMITIVE_LINES:
+            for(size_t i = 0; i + 1 < count; i += 2) segment(i, i + 1);
+            break;
+        case PRIMITIVE_LINE_STRIP:
+        case PRIMITIVE_LINE_LOOP:
+            for(size_t i = 0; i + 1 < count; i++) segment(i, i + 1);
+            if(mode == PRIMITIVE_LINE_LOOP && count > 2) segment(count - 1, 0);
+            break;
+        default:
+            return;
+    }
+    renderStats.drawCalls++;
+    renderStats.verticesUploaded += count;
+}
+
+void CpuRasterizer::drawIndexedRanges(const ViewTransform& view, const DrawRange* ranges, size_t rangeCount,
+                                      const uint32_t* indices, size_t indexCount, const DrawBatch* batches, size_t batchCount) {
+    if(indexCount == 0) return;
+    // the concatenation the indices refer to, as the GL path uploads it
+    vertices.clear();
+    for(size_t r = 0; r < rangeCount; r++) vertices.insert(vertices.end(), ranges[r].data, ranges[r].data + ranges[r].count);
+    renderStats.verticesUploaded += vertices.size();
+
+    double halfW = targetWidth * 0.5, halfH = targetHeight * 0.5;
+    for(size_t b = 0; b < batchCount; b++) {
+        const DrawBatch& batch = batches[b];
+        // packed -> window pixels as one affine map per axis, the offset taken in double
+        float offsetX = (float)(((batch.originX - view.centerX) * view.scaleX + 1.0) * halfW);
+        float offsetY = (float)(((batch.originY - view.centerY) * view.scaleY + 1.0) * halfH);
+        float unitX = (float)(batch.extent / QUANTIZATION_MAX * view.scaleX * halfW);
+        float unitY = (float)(batch.extent / QUANTIZATION_MAX * view.scaleY * halfH);
+        const uint32_t* index = indices + batch.firstIndex;
+        const uint32_t* end = index + batch.indexCount;
+        if(batch.mode == PRIMITIVE_POINTS) {
+            for(; index < end; index++) {
+                if(*index == PRIMITIVE_RESTART_INDEX) continue;
+                const PackedVertex& v = vertices[*index];
+                float x = offsetX + v.x * unitX, y = offsetY + v.y * unitY;
+                addSegment(x, y, x, y, POINT_HALF_WIDTH, batch.color);
+            }
+        }
+        else if(batch.mode == PRIMITIVE_LINE_STRIP) {
+            bool open = false;
+            float lastX = 0, lastY = 0;
+            for(; index < end; index++) {
+                if(*index == PRIMITIVE_RESTART_INDEX) {
+                    open = false;
+                    continue;
+                }
+                const PackedVertex& v = vertices[*index];
+                float x = offsetX + v.x * unitX, y = offsetY + v.y * unitY;
+                if(open) addSegment(lastX, lastY, x, y, LINE_HALF_WIDTH, batch.color);
+                lastX = x;
+                lastY = y;
+                open = true;
+            }
+        }
+    }
+    renderStats.drawCalls += (int)batchCount;
+}
+
+void CpuRasterizer::binChunk(size_t chunk, size_t first, size_t last) {
+    size_t tileCount = (size_t)tilesX * tilesY;
+    std::vector<uint32_t>* chunkBins = &bins[chunk * tileCount];
+    for(size_t tile = 0; tile < tileCount; tile++) chunkBins[tile].clear();
+    // a tile is touched when its center is within half a diagonal (plus the line reach) of the segment
+    const float tileRadius = RASTER_TILE_SIZE * 0.70711f;
+    for(size_t i = first; i < last; i++) {
+        const Primitive& p = primitives[i];
+        float reach = p.halfWidth + 1.0f;
+        int tx0 = std::max(0, (int)std::floor((std::min(p.x0, p.x1) - reach) / RASTER_TILE_SIZE));
+        int tx1 = std::min(tilesX - 1, (int)std::floor((std::max(p.x0, p.x1) + reach) / RASTER_TILE_SIZE));
+        int ty0 = std::max(0, (int)std::floor((std::min(p.y0, p.y1) - reach) / RASTER_TILE_SIZE));
+        int ty1 = std::min(tilesY - 1, (int)std::floor((std::max(p.y0, p.y1) + reach) / RASTER_TILE_SIZE));
+        float dx = p.x1 - p.x0, dy = p.y1 - p.y0;
+        float length = std::sqrt(dx * dx + dy * dy);
+        bool oneRowOrColumn = tx0 == tx1 || ty0 == ty1;
+        for(int ty = ty0; ty <= ty1; ty++) {
+            for(int tx = tx0; tx <= tx1; tx++) {
+                if(!oneRowOrColumn && length > 0) {
+                    // distance from the tile center to the segment's line
+                    float cx = (tx + 0.5f) * RASTER_TILE_SIZE - p.x0, cy = (ty + 0.5f) * RASTER_TILE_SIZE - p.y0;
+                    if(std::abs(cx * dy - cy * dx) > (tileRadius + reach) * length) continue;
+                }
+                chunkBins[(size_t)ty * tilesX + tx].push_back((uint32_t)i);
+            }
+        }
+    }
+}
+
+void CpuRasterizer::rasterTile(size_t tile) {
+    const int T = RASTER_TILE_SIZE;
+    int tileX = (int)(tile % tilesX) * T, tileY = (int)(tile / tilesX) * T;
+    int width = std::min(T, targetWidth - tileX), height = std::min(T, targetHeight - tileY);
+    size_t tileCount = (size_t)tilesX * tilesY;
+
+    // the tile is blended in float; columns past a partial tile are computed but never stored
+    alignas(16) float red[T * T], green[T * T], blue[T * T];
+    for(int y = 0; y < height; y++) {
+        const unsigned char* row = &framebuffer[((size_t)(tileY + y) * targetWidth + tileX) * 4];
+        for(int x = 0; x < width; x++) {
+            red[y * T + x] = row[4 * x] * (1.0f / 255);
+            green[y * T + x] = row[4 * x + 1] * (1.0f / 255);
+            blue[y * T + x] = row[4 * x + 2] * (1.0f / 255);
+        }
+    }
+
+    const Pixels zero = {}, one = zero + 1.0f;
+    for(size_t chunk = 0; chunk < chunkCount; chunk++) {
+        for(uint32_t index : bins[chunk * tileCount + tile]) {
+            const Primitive& p = primitives[index];
+            float reach = p.halfWidth + 0.5f;
+            int x0 = std::max(0, (int)std::floor(std::min(p.x0, p.x1) - reach) - tileX) & ~3;
+            int x1 = std::min(width, (int)std::ceil(std::max(p.x0, p.x1) + reach) - tileX);
+            int y0 = std::max(0, (int)std::floor(std::min(p.y0, p.y1) - reach) - tileY);
+            int y1 = std::min(height, (int)std::ceil(std::max(p.y0, p.y1) + reach) - tileY);
+            float dx = p.x1 - p.x0, dy = p.y1 - p.y0;
+            float length2 = dx * dx + dy * dy;
+            float inverseLength2 = length2 > 0 ? 1.0f / length2 : 0.0f;
+            for(int y = y0; y < y1; y++) {
+                float py = tileY + y + 0.5f - p.y0;
+                for(int x = x0; x < x1; x += 4) {
+                    // distance of four pixel centers to the segment, coverage falls off over one pixel
+                    Pixels px = LANE_OFFSETS + (float)(tileX + x) - p.x0;
+                    Pixels t = (px * dx + py * dy) * inverseLength2;
+                    t = t < zero ? zero : t;
+                    t = t > one ? one : t;
+                    Pixels ex = px - t * dx, ey = py - t * dy;
+                    Pixels distance2 = ex * ex + ey * ey;
+                    Pixels coverage;
+                    for(int lane = 0; lane < 4; lane++) coverage[lane] = reach - std::sqrt(distance2[lane]);
+                    coverage = coverage < zero ? zero : coverage;
+                    coverage = coverage > one ? one : coverage;
+                    Pixels* r = (Pixels*)&red[y * T + x];
+                    Pixels* g = (Pixels*)&green[y * T + x];
+                    Pixels* b = (Pixels*)&blue[y * T + x];
+                    *r += (p.color[0] - *r) * coverage;
+                    *g += (p.color[1] - *g) * coverage;
+                    *b += (p.color[2] - *b) * coverage;
+                }
+            }
+        }
+    }
+
+    for(int y = 0; y < height; y++) {
+        unsigned char* row = &framebuffer[((size_t)(tileY + y) * targetWidth + tileX) * 4];
+        for(int x = 0; x < width; x++) {
+            row[4 * x] = (unsigned char)(red[y * T + x] * 255 + 0.5f);
+            row[4 * x + 1] = (unsigned char)(green[y * T + x] * 255 + 0.5f);
+            row[4 * x + 2] = (unsigned char)(blue[y * T + x] * 255 + 0.5f);
+        }
+    }
+}
+
+void CpuRasterizer::finish() {
+    stats = RasterStats();
+    stats.primitives = primitives.size();
+    if(primitives.empty()) return;
+
+    // each chunk bins a contiguous slice, so walking the chunks in order keeps the draw order
+    auto start = std::chrono::steady_clock::now();
+    size_t tileCount = (size_t)tilesX * tilesY;
+    chunkCount = (primitives.size() + BIN_CHUNK_PRIMITIVES - 1) / BIN_CHUNK_PRIMITIVES;
+    if(bins.size() < chunkCount * tileCount) bins.resize(chunkCount * tileCount);
+    pool.parallelFor(chunkCount, [&](size_t chunk) {
+        binChunk(chunk, chunk * BIN_CHUNK_PRIMITIVES, std::min(primitives.size(), (chunk + 1) * BIN_CHUNK_PRIMITIVES));
+    });
+    for(size_t i = 0; i < chunkCount * tileCount; i++) stats.binEntries += bins[i].size();
+    stats.binMs = elapsedMs(start);
+
+    start = std::chrono::steady_clock::now();
+    pool.parallelFor(tileCount, [&](size_t tile) { rasterTile(tile); });
+    stats.rasterMs = elapsedMs(start);
+    primitives.clear();
+}
+
+// ---- Headless rendering ----
+
+int runHeadlessRender(FILE* in, const char* path, int width, int height) {
+    double values[SCENE_RECORD_VALUES];
+    int count = readSceneRecord(in, values);
+    if(count < 12) {
+        fprintf(stderr, "render: expected a record x1 y1 x2 y2 x3 y3 u1 v1 u2 v2 u3 v3 [qx qy] on the input\n");
+        return 1;
+    }
+
+    static FrameGeometry background, foreground;
+    auto start = std::chrono::steady_clock::now();
+    buildRecordScene(values, count, width, height, background, foreground);
+    double buildMs = elapsedMs(start);
+
+    CpuRasterizer raster(width, height);
+    setRenderBackend(raster);
+    start = std::chrono::steady_clock::now();
+    raster.clear(0, 0, 0);
+    background.submit();
+    foreground.submit();
+    raster.finish();
+    double drawMs = elapsedMs(start);
+
+    if(!writePng(path, raster.pixels(), width, height)) {
+        fprintf(stderr, "render: could not write %s\n", path);
+        return 1;
+    }
+    printf("render: %dx%d to %s, build %.2f ms, raster %.2f ms (%zu primitives, %u threads)\n",
+           width, height, path, buildMs, drawMs, raster.lastStats().primitives, TaskPool::shared().size());
+    return 0;
+}
@@ -0,0 +1,122 @@
+#include <GL/glew.h>
+#include <cstdio>
+#include <vector>
+#include "drawStream.h"
+#include "renderBackend.h"
+#include "utils.h"
+
+static const char* DEFAULT_DRAW_STREAM_PATH = "pappus-draws.pds";
+
+static_assert(sizeof(PackedVertex) == 2 * sizeof(int16_t), "the stream stores packed vertices as int16_t pairs");
+
+// Writes every call to the stream, then hands it to the backend that was active before
+class DrawStreamRecorder : public RenderBackend {
+public:
+    FILE* file = nullptr;
+    RenderBackend* target = nullptr;
+    uint32_t frames = 0;
+    uint64_t draws = 0;
+    uint64_t bytes = 0;
+    // a short write or a failed close, reported when the recording stops
+    bool failed = false;
+
+    void drawVertices(const float* data, size_t floatCount, PrimitiveMode mode, const ViewTransform& view) override {
+        if(floatCount != 0) {
+            float m[9];
+            view.relativeMatrix(m);
+            float origin[2] = {(float)-view.centerX, (float)-view.centerY};
+            put(DRAW_STREAM_VERTICES);
+            put((uint32_t)mode);
+            write(m, sizeof m);
+            write(origin, sizeof origin);
+            put((uint32_t)floatCount);
+            write(data, floatCount * sizeof(float));
+            draws++;
+        }
+        target->drawVertices(data, floatCount, mode, view);
+    }
+
+    void drawIndexedRanges(const ViewTransform& view, const DrawRange* ranges, size_t rangeCount,
+                           const uint32_t* indices, size_t indexCount, const DrawBatch* batches, size_t batchCount) override {
+        if(indexCount != 0) {
+            float m[9];
+            view.relativeMatrix(m);
+            size_t vertexCount = 0;
+            for(size_t r = 0; r < rangeCount; r++) vertexCount += ranges[r].count;
+            put(DRAW_STREAM_PACKED);
+            write(m, sizeof m);
+            put((uint32_t)vertexCount);
+            put((uint32_t)indexCount);
+            put((uint32_t)batchCount);
+            // concatenated exactly as the GL backend uploads them, so the indices stay valid
+            for(size_t r = 0; r < rangeCount; r++) write(ranges[r].data, ranges[r].count * sizeof(PackedVertex));
+            write(indices, indexCount * sizeof(uint32_t));
+            for(size_t b = 0; b < batchCount; b++) {
+                const DrawBatch& batch = batches[b];
+                DrawStreamBatch record = {(uint32_t)batch.mode, (uint32_t)batch.firstIndex, (uint32_t)batch.indexCount,
+                                          {(float)(batch.originX - view.centerX), (float)(batch.originY - view.centerY)},
+                                          batch.extent / QUANTIZATION_MAX,
+                                          {batch.color[0], batch.color[1], batch.color[2]}};
+                write(&record, sizeof record);
+            }
+            draws += batchCount;
+        }
+        target->drawIndexedRanges(view, ranges, rangeCount, indices, indexCount, batches, batchCount);
+    }
+
+    const char* name() const override { return "recorder"; }
+
+    void put(uint32_t value) { write(&value, sizeof value); }
+    void write(const void* data, size_t size) {
+        if(fwrite(data, 1, size, file) != size) failed = true;
+        bytes += size;
+    }
+};
+
+static DrawStreamRecorder recorder;
+
+bool recordingDrawStream() {
+    return recorder.file != nullptr;
+}
+
+bool startDrawStream(const char* path) {
+    if(recordingDrawStream()) return true;
+    recorder.file = fopen(path, "wb");
+    if(!recorder.file) {
+        fprintf(stderr, "Cannot write draw stream to %s\n", path);
+        return false;
+    }
+    // large blocks, so the draw calls do not wait on the disk
+    setvbuf(recorder.file, nullptr, _IOFBF, 1 << 22);
+    recorder.frames = 0;
+    recorder.draws = 0;
+    recorder.bytes = 0;
+    recorder.failed = false;
+    DrawStreamHeader header = {DRAW_STREAM_MAGIC, DRAW_STREAM_VERSION, (uint32_t)currentWindowWidth, (uint32_t)currentWindowHeight};
+    recorder.write(&header, sizeof header);
+    recorder.target = &activeRenderBackend();
+    setRenderBackend(recorder);
+    printf("draw stream: recording %dx%d to %s\n", currentWindowWidth, currentWindowHeight, path);
+    return true;
+}
+
+void stopDrawStream() {
+    if(!recordingDrawStream()) return;
+    setRenderBackend(*recorder.target);
+    if(fclose(recorder.file) != 0) recorder.failed = true;
+    recorder.file = nullptr;
+    printf("draw stream: %u frames, %llu draws, %.2f MB%s\n", recorder.frames,
+           (unsigned long long)recorder.draws, recorder.bytes / (1024.0 * 1024.0),
+           recorder.failed ? "; WRITE ERRORS" : "");
+}
+
+void toggleDrawStream() {
+    if(recordingDrawStream()) stopDrawStream();
+    else startDrawStream(DEFAULT_DRAW_STREAM_PATH);
+}
+
+void markDrawStreamFrame() {
+    if(!recordingDrawStream()) return;
+    recorder.put(DRAW_STREAM_FRAME);
+    recorder.put(recorder.frames++);
+}
@@ -0,0 +1,416 @@
+#include <GL/glew.h>
+#include <GL/glut.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <vector>
+#include "gallery.h"
+#include "camera.h"
+#include "graphics.h"
+#include "utils.h"
+#include "pappus.h"
+#include "TaskPool.h"
+
+bool galleryMode = false;
+
+// segments of half a unit circle; rings use twice as many
+static const int GALLERY_ARC_SEGMENTS = 256;
+static const int MAX_ARCS_PER_CONSTRUCTION = 5;   // both lines with their opposite halves, Pappus line
+static const int MAX_RINGS_PER_CONSTRUCTION = 19; // disk, six points and three intersections, antipodes included
+static const int SWEEP_WARMUP_FRAMES = 5;
+static const int SWEEP_FRAMES = 30;
+
+// one instance: center + A*(cos t, sin t) in disk units, placed by the transform of its construction
+struct GalleryCurve {
+    float axes[4];
+    float center[2];
+    float color[3];
+    GLint construction;
+};
+
+// std140: center x, y, scale, unused
+struct GalleryCellBlock {
+    float cells[MAX_GALLERY_CONSTRUCTIONS][4];
+};
+
+struct GalleryPoints {
+    Vector3 x[3], y[3];
+};
+
+static GLuint galleryProgram = 0;
+static GLuint unitVbo = 0, instanceVbo = 0, cellUbo = 0;
+static GLuint arcVao = 0, ringVao = 0;
+static GLint uni_uGalleryView = -1;
+
+static int constructionCount = 16;
+static bool instancesDirty = true;
+static std::vector<GalleryPoints> loadedPoints;
+static GalleryCellBlock cellBlock;
+static size_t arcInstanceCount = 0, ringInstanceCount = 0;
+static double lastBuildMs = 0.0;
+static double lastSubmitMs = 0.0;
+
+static bool sweeping = false;
+static int sweepSize = 1;
+static int sweepFrame = 0;
+static double sweepAccumulatedMs = 0.0;
+static int sweepRestoreSize = 16;
+
+static const char* galleryVertexShaderSrc = R"glsl(
+#version 330 core
+#define MAX_CONSTRUCTIONS 1024
+layout(location = 0) in vec2 inUnit;         // (cos t, sin t), shared by every instance
+layout(location = 1) in vec4 inAxes;         // A columns in disk units
+layout(location = 2) in vec2 inCenter;
+layout(location = 3) in vec3 inColor;
+layout(location = 4) in int inConstruction;
+layout(std140) uniform GalleryBlock {
+    vec4 uCells[MAX_CONSTRUCTIONS];          // center xy, scale
+};
+uniform mat3 uView;
+out vec3 fragColor;
+void main() {
+    fragColor = inColor;
+    vec2 local = inCenter + inAxes.xy * inUnit.x + inAxes.zw * inUnit.y;
+    vec4 cell = uCells[inConstruction];
+    vec2 inPos = cell.xy + local * cell.z;
+    gl_Position = vec4((uView * vec3(inPos, 1.0)).xy, 0.0, 1.0);
+}
+)glsl";
+
+static const char* galleryFragmentShaderSrc = R"glsl(
+#version 330 core
+in vec3 fragColor;
+out vec4 outColor;
+void main() {
+    outColor = vec4(fragColor, 1.0);
+}
+)glsl";
+
+// per-instance attributes start at firstInstance inside the shared instance buffer
+static void setInstanceAttributes(GLuint vao, size_t firstInstance) {
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVbo);
+    const char* base = (const char*)(firstInstance * sizeof(GalleryCurve));
+    GLsizei stride = sizeof(GalleryCurve);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, stride, base + offsetof(GalleryCurve, axes));
+    glVertexAttribDivisor(1, 1);
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, base + offsetof(GalleryCurve, center));
+    glVertexAttribDivisor(2, 1);
+    glEnableVertexAttribArray(3);
+    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, stride, base + offsetof(GalleryCurve, color));
+    glVertexAttribDivisor(3, 1);
+    glEnableVertexAttribArray(4);
+    glVertexAttribIPointer(4, 1, GL_INT, stride, base + offsetof(GalleryCurve, construction));
+    glVertexAttribDivisor(4, 1);
+    glBindVertexArray(0);
+}
+
+void initGalleryResources() {
+    galleryProgram = buildProgram(galleryVertexShaderSrc, galleryFragmentShaderSrc);
+    uni_uGalleryView = glGetUniformLocation(galleryProgram, "uView");
+    GLuint blockIndex = glGetUniformBlockIndex(galleryProgram, "GalleryBlock");
+    if(blockIndex != GL_INVALID_INDEX) glUniformBlockBinding(galleryProgram, blockIndex, 1);
+
+    // half circle followed by a full circle, both starting at t = 0
+    std::vector<float> unit;
+    for(int k = 0; k <= GALLERY_ARC_SEGMENTS; k++) {
+        double t = k * M_PI / GALLERY_ARC_SEGMENTS;
+        unit.push_back((float)cos(t));
+        unit.push_back((float)sin(t));
+    }
+    for(int k = 0; k <= 2 * GALLERY_ARC_SEGMENTS; k++) {
+        double t = k * M_PI / GALLERY_ARC_SEGMENTS;
+        unit.push_back((float)cos(t));
+        unit.push_back((float)sin(t));
+    }
+    glGenBuffers(1, &unitVbo);
+    glBindBuffer(GL_ARRAY_BUFFER, unitVbo);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(unit.size() * sizeof(float)), unit.data(), GL_STATIC_DRAW);
+
+    glGenBuffers(1, &instanceVbo);
+    glGenVertexArrays(1, &arcVao);
+    glGenVertexArrays(1, &ringVao);
+    GLuint vaos[2] = {arcVao, ringVao};
+    for(GLuint vao : vaos) {
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, unitVbo);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 2, (void*)0);
+    }
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glGenBuffers(1, &cellUbo);
+    glBindBuffer(GL_UNIFORM_BUFFER, cellUbo);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(GalleryCellBlock), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void setGallerySize(int count) {
+    count = std::max(1, std::min(count, MAX_GALLERY_CONSTRUCTIONS));
+    if(count == constructionCount) return;
+    constructionCount = count;
+    instancesDirty = true;
+}
+
+int gallerySize() {
+    return constructionCount;
+}
+
+// move p onto the great circle through a and b, keeping it on the upper hemisphere
+static Vector3 snapToLine(const Vector3& p, const Vector3& a, const Vector3& b) {
+    Vector3 normal = a.cross(b);
+    double lengthSquared = normal.dot(normal);
+    if(lengthSquared == 0) return p;
+    Vector3 snapped = (p - normal * (p.dot(normal) / lengthSquared)).normalize() * circleRadius;
+    if(snapped[2] < 0) snapped = snapped * -1;
+    return snapped;
+}
+
+bool loadGalleryPoints(const char* path) {
+    std::ifstream in(path);
+    if(!in) {
+        std::cerr << "Could not open gallery points file " << path << std::endl;
+        return false;
+    }
+    loadedPoints.clear();
+    std::string line;
+    while(std::getline(in, line) && (int)loadedPoints.size() < MAX_GALLERY_CONSTRUCTIONS) {
+        std::istringstream fields(line);
+        double values[12];
+        int read = 0;
+        while(read < 12 && fields >> values[read]) read++;
+        if(read < 12) continue;
+        GalleryPoints points;
+        for(int k = 0; k < 6; k++) {
+            double px = values[2 * k], py = values[2 * k + 1];
+            capDistance2D(px, py);
+            Vector3& target = k < 3 ? points.x[k] : points.y[k - 3];
+            target = liftToSphere(px, py, circleRadius);
+        }
+        points.x[2] = snapToLine(points.x[2], points.x[0], points.x[1]);
+        points.y[2] = snapToLine(points.y[2], points.y[0], points.y[1]);
+        loadedPoints.push_back(points);
+    }
+    instancesDirty = true;
+    return true;
+}
+
+// three well separated points on a random great circle that crosses the disk visibly
+static void randomTriple(std::mt19937& rng, Vector3 out[3]) {
+    std::uniform_real_distribution<double> unit(-1.0, 1.0);
+    Vector3 normal;
+    do {
+        normal = Vector3(unit(rng), unit(rng), unit(rng));
+        // nearly horizontal planes project to lines hugging the disk boundary, which read poorly
+    } while(normal.magnitude() < 0.1 || fabs(normal[2]) > 0.85 * normal.magnitude());
+    normal = normal.normalize();
+    Vector3 u = normal.cross(fabs(normal[0]) < 0.9 ? Vector3(1, 0, 0) : Vector3(0, 1, 0)).normalize();
+    Vector3 v = normal.cross(u);
+    std::uniform_real_distribution<double> jitter(0.15, 0.85);
+    for(int k = 0; k < 3; k++) {
+        double angle = (k + jitter(rng)) * M_PI / 3;
+        Vector3 p = (u * cos(angle) + v * sin(angle)) * circleRadius;
+        if(p[2] < 0) p = p * -1;
+        out[k] = p;
+    }
+}
+
+// fixed-size slots so constructions can be generated concurrently
+struct ConstructionCurves {
+    GalleryCurve arcs[MAX_ARCS_PER_CONSTRUCTION];
+    GalleryCurve rings[MAX_RINGS_PER_CONSTRUCTION];
+    int arcCount = 0;
+    int ringCount = 0;
+    GLint construction = 0;
+
+    void add(GalleryCurve* list, int& count, float a00, float a10, float a01, float a11, float cx, float cy, Vector3 color) {
+        GalleryCurve& curve = list[count++];
+        curve.axes[0] = a00; curve.axes[1] = a10; curve.axes[2] = a01; curve.axes[3] = a11;
+        curve.center[0] = cx; curve.center[1] = cy;
+        curve.color[0] = color[0]; curve.color[1] = color[1]; curve.color[2] = color[2];
+        curve.construction = construction;
+    }
+
+    void addLine(const Vector3& p1, const Vector3& p2, Vector3 color, bool arcOnly = false) {
+        GreatCircle line = GreatCircle::through(p1, p2);
+        float r = circleRadius;
+        const Vector3& u = line.u();
+        const Vector3& v = line.v();
+        add(arcs, arcCount, r * u[0], r * u[1], r * v[0], r * v[1], 0, 0, color);
+        // the other half of the great circle, as the tessellated path does near the ideal line
+        if(!arcOnly && line.needsOppositeHalf()) {
+            add(arcs, arcCount, -r * u[0], -r * u[1], -r * v[0], -r * v[1], 0, 0, color);
+        }
+    }
+
+    void addRing(double cx, double cy, float radius, Vector3 color) {
+        add(rings, ringCount, radius, 0, 0, radius, cx, cy, color);
+    }
+
+    void addMarker(const Vector3& p, Vector3 color) {
+        addRing(p[0], p[1], 7, color);
+        if(checkInfinityPoint(p[0], p[1])) addRing(-p[0], -p[1], 7, color);
+    }
+};
+
+static void buildConstruction(int index, ConstructionCurves& out) {
+    GalleryPoints points;
+    if(index < (int)loadedPoints.size()) {
+        points = loadedPoints[index];
+    }
+    else {
+        // seeded by slot so growing the gallery keeps the existing constructions
+        std::mt19937 rng(1000u + index);
+        randomTriple(rng, points.x);
+        randomTriple(rng, points.y);
+    }
+    PappusConfiguration config = computePappus(points.x, points.y);
+
+    out.construction = index;
+    out.addRing(0, 0, circleRadius, Vector3(0.4, 0.4, 0.4));
+    out.addLine(points.x[0], points.x[1], Vector3(1, 1, 1));
+    out.addLine(points.y[0], points.y[1], Vector3(1, 1, 1));
+    out.addLine(config.chosen1, config.chosen2, Vector3(0.5, 1, 0.5), true);
+    for(int k = 0; k < 3; k++) {
+        // same per-index palette as the interactive markers
+        float rgbValues[3] = {0.85f, 0.85f, 0.85f};
+        rgbValues[k] = 0.15f;
+        Vector3 color(rgbValues[0], rgbValues[1], rgbValues[2]);
+        out.addMarker(points.x[k], color);
+        out.addMarker(points.y[k], color);
+    }
+    for(Vector3 intersection : config.intersections) {
+        // intersections come back on either hemisphere, the disk shows the upper one
+        if(intersection[2] < 0) intersection = intersection * -1;
+        out.addMarker(intersection, Vector3(0.6, 0.6, 0.6));
+    }
+}
+
+// grid filling the world rectangle with square cells
+static void layoutCells(int count) {
+    float worldWidth = WORLD_RIGHT - WORLD_LEFT;
+    float worldHeight = WORLD_TOP - WORLD_BOTTOM;
+    int columns = std::max(1, (int)std::ceil(std::sqrt(count * worldWidth / worldHeight)));
+    int rows = (count + columns - 1) / columns;
+    float cell = std::min(worldWidth / columns, worldHeight / rows);
+    float left = WORLD_LEFT + (worldWidth - columns * cell) * 0.5f;
+    float top = WORLD_TOP - (worldHeight - rows * cell) * 0.5f;
+    // leave room for the antipodal markers outside the disk
+    float scale = 0.45f * cell / (circleRadius + 7);
+    for(int i = 0; i < count; i++) {
+        float* c = cellBlock.cells[i];
+        c[0] = left + (i % columns + 0.5f) * cell;
+        c[1] = top - (i / columns + 0.5f) * cell;
+        c[2] = scale;
+        c[3] = 0.0f;
+    }
+}
+
+static void rebuildInstances() {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<ConstructionCurves> slots(constructionCount);
+    TaskPool::shared().parallelFor(slots.size(), [&](size_t i) {
+        buildConstruction((int)i, slots[i]);
+    });
+
+    // arcs first, then rings, so each draw reads one contiguous run of instances
+    std::vector<GalleryCurve> curves;
+    curves.reserve(slots.size() * (MAX_ARCS_PER_CONSTRUCTION + MAX_RINGS_PER_CONSTRUCTION));
+    for(const ConstructionCurves& slot : slots) curves.insert(curves.end(), slot.arcs, slot.arcs + slot.arcCount);
+    arcInstanceCount = curves.size();
+    for(const ConstructionCurves& slot : slots) curves.insert(curves.end(), slot.rings, slot.rings + slot.ringCount);
+    ringInstanceCount = curves.size() - arcInstanceCount;
+
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVbo);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(curves.size() * sizeof(GalleryCurve)), curves.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    setInstanceAttributes(arcVao, 0);
+    setInstanceAttributes(ringVao, arcInstanceCount);
+
+    layoutCells(constructionCount);
+    glBindBuffer(GL_UNIFORM_BUFFER, cellUbo);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(float) * 4 * constructionCount, cellBlock.cells);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    instancesDirty = false;
+    lastBuildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void startGallerySweep() {
+    galleryMode = true;
+    sweeping = true;
+    sweepRestoreSize = constructionCount;
+    sweepSize = 1;
+    sweepFrame = 0;
+    sweepAccumulatedMs = 0.0;
+    setGallerySize(sweepSize);
+    printf("gallery sweep: %d frames per size\n%8s %12s %16s %12s\n", SWEEP_FRAMES, "N", "frame ms", "ms/construction", "instances");
+    glutPostRedisplay();
+}
+
+static void advanceSweep(double frameMs) {
+    if(sweepFrame++ >= SWEEP_WARMUP_FRAMES) sweepAccumulatedMs += frameMs;
+    if(sweepFrame < SWEEP_WARMUP_FRAMES + SWEEP_FRAMES) {
+        glutPostRedisplay();
+        return;
+    }
+    double average = sweepAccumulatedMs / SWEEP_FRAMES;
+    printf("%8d %12.3f %16.5f %12zu\n", sweepSize, average, average / sweepSize, arcInstanceCount + ringInstanceCount);
+    if(sweepSize == MAX_GALLERY_CONSTRUCTIONS) {
+        sweeping = false;
+        setGallerySize(sweepRestoreSize);
+    }
+    else {
+        sweepSize = std::min(sweepSize * 2, MAX_GALLERY_CONSTRUCTIONS);
+        setGallerySize(sweepSize);
+    }
+    sweepFrame = 0;
+    sweepAccumulatedMs = 0.0;
+    glutPostRedisplay();
+}
+
+void drawGallery() {
+    if(instancesDirty) rebuildInstances();
+
+    auto start = std::chrono::steady_clock::now();
+    glUseProgram(galleryProgram);
+    glBindBufferBase(GL_UNIFORM_BUFFER, 1, cellUbo);
+    if(uni_uGalleryView != -1) {
+        // the grid lives in world coordinates, so the full view matrix is enough
+        float view[9];
+        currentView().worldMatrix(view);
+        glUniformMatrix3fv(uni_uGalleryView, 1, GL_FALSE, view);
+    }
+
+    glBindVertexArray(arcVao);
+    glDrawArraysInstanced(GL_LINE_STRIP, 0, GALLERY_ARC_SEGMENTS + 1, (GLsizei)arcInstanceCount);
+    glBindVertexArray(ringVao);
+    glDrawArraysInstanced(GL_LINE_STRIP, GALLERY_ARC_SEGMENTS + 1, 2 * GALLERY_ARC_SEGMENTS + 1, (GLsizei)ringInstanceCount);
+    renderStats.drawCalls += 2;
+
+    glBindVertexArray(0);
+    glUseProgram(0);
+    if(!sweeping) {
+        // interactive frames must not stall on the GPU; the HUD shows the submission time
+        lastSubmitMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return;
+    }
+    // wait for the GPU so the time covers the whole frame, not just command submission
+    glFinish();
+    advanceSweep(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+}
+
+void formatGalleryHud(char* hud, size_t size) {
+    snprintf(hud, size, "gallery N=%d  submit %.3f ms\ndraws 2  instances %zu  rebuilt in %.3f ms",
+             constructionCount, lastSubmitMs, arcInstanceCount + ringInstanceCount, lastBuildMs);
+}
@@ -4,19 +4,51 @@
 #include <vector>
 #include <iostream>
 #include <algorithm>
+#include <cstdio>
 #include "graphics.h"
 #include "utils.h"
 #include "Vector3.h"
 #include "Matrix3.h"
+#include "conics.h"
+#include "pipeline.h"
+#include "allocationCounter.h"
+#include "pappus.h"
+#include "gallery.h"
+#include "quality.h"
+#include "programCache.h"
+#include "startupTiming.h"
+#include "antialiasing.h"
+#include "backgroundLayer.h"
+#include "capture.h"
+#include "camera.h"
+#include "textOverlay.h"
+#include "renderBackend.h"
+#include "trail.h"
+#include "snapping.h"
+#include "sceneShaders.h"
+#include "drawStream.h"
+#include "iteratedPappus.h"
+#include "hemisphereView.h"
+#include <chrono>
+#include <random>
 
 GLuint shaderProgram = 0;
-static GLuint vao = 0, vbo = 0;
+// vao reads PackedVertex positions with the color as a per-draw constant attribute,
+// interleavedVao the x,y,r,g,b floats of drawVertices; all of them stream through vbo
+// and textVao the x,y,r,g,b,u,v floats of the glyph quads
+static GLuint vao = 0, interleavedVao = 0, textVao = 0, vbo = 0, ibo = 0;
 static size_t vboCapacityBytes = 0; // track current VBO allocation
-// uniform locations for smoothing and viewport
+static size_t iboCapacityBytes = 0;
+// uniform locations for smoothing and the camera view
 static GLint uni_uAlpha = -1;
 static GLint uni_uPointSize = -1;
 static GLint uni_uIsPoint = -1;
-static GLint uni_uViewportSize = -1;
+static GLint uni_uView = -1;
+static GLint uni_uOrigin = -1;
+static GLint uni_uPositionScale = -1;
+static GLint uni_uIsText = -1;
+static GLint uni_uGlyphAtlas = -1;
+
 
 // smoothing for interactive/mouse-driven visuals (render-only, not changing stored data)
 static double drawMarkedX[6] = {0}, drawMarkedY[6] = {0};
@@ -26,64 +58,7 @@ static double targetInteractiveX = 0.0, targetInteractiveY = 0.0;
 static bool smoothingInitialized = false;
 static const float smoothingFactor = 0.25f; // 0..1, larger = faster (less smooth)
 
-// Improved vertex shader: dynamic viewport mapping
-static const char* vertexShaderSrc = R"glsl(
-#version 330 core
-layout(location = 0) in vec2 inPos;
-layout(location = 1) in vec3 inColor;
-out vec3 fragColor;
-uniform float uPointSize;
-uniform int uIsPoint;
-uniform vec2 uViewportSize;
-void main() {
-    fragColor = inColor;
-    // Dynamic coordinate mapping based on viewport aspect ratio
-    float worldWidth = 1560.0;   // WORLD_RIGHT - WORLD_LEFT
-    float worldHeight = 840.0;   // WORLD_TOP - WORLD_BOTTOM
-    float aspectRatio = uViewportSize.x / uViewportSize.y;
-    float worldAspectRatio = worldWidth / worldHeight;
-    
-    vec2 scaledPos = inPos;
-    if(aspectRatio > worldAspectRatio) {
-        // Viewport is wider than world, scale X to maintain aspect ratio
-        scaledPos.x = inPos.x / (780.0 * aspectRatio / worldAspectRatio);
-        scaledPos.y = inPos.y / 420.0;
-    } else {
-        // Viewport is taller than world, scale Y to maintain aspect ratio
-        scaledPos.x = inPos.x / 780.0;
-        scaledPos.y = inPos.y / (420.0 * worldAspectRatio / aspectRatio);
-    }
-    
-    gl_Position = vec4(scaledPos, 0.0, 1.0);
-    if(uIsPoint == 1) {
-        gl_PointSize = uPointSize;
-    }
-}
-)glsl";
-
-// Improved fragment shader: support alpha and smooth round points using gl_PointCoord
-static const char* fragmentShaderSrc = R"glsl(
-#version 330 core
-in vec3 fragColor;
-out vec4 outColor;
-uniform float uAlpha;
-uniform int uIsPoint;
-void main() {
-    float alpha = uAlpha;
-    // If rendering points, make them round and smooth using gl_PointCoord
-    if(uIsPoint == 1) {
-        // gl_PointCoord is only valid for points
-        vec2 pc = gl_PointCoord.xy - vec2(0.5);
-        float dist = length(pc);
-        // smoothstep to create soft circular alpha (0.0..0.5 radius)
-        float smoothA = smoothstep(0.5, 0.45, dist);
-        alpha *= smoothA;
-    }
-    outColor = vec4(fragColor, alpha);
-}
-)glsl";
-
-static GLuint compileShader(GLenum type, const char* src) {
+GLuint compileShader(GLenum type, const char* src) {
     GLuint s = glCreateShader(type);
     glShaderSource(s, 1, &src, nullptr);
     glCompileShader(s);
@@ -97,86 +72,129 @@ static GLuint compileShader(GLenum type, const char* src) {
     return s;
 }
 
-void initGLResources() {
-    // compile shaders
-    GLuint vs = compileShader(GL_VERTEX_SHADER, vertexShaderSrc);
-    GLuint fs = compileShader(GL_FRAGMENT_SHADER, fragmentShaderSrc);
-    shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vs);
-    glAttachShader(shaderProgram, fs);
-    glLinkProgram(shaderProgram);
+GLuint buildProgram(const char* vsSrc, const char* fsSrc) {
+    // a binary from a previous run skips compiling and linking altogether
+    GLuint cached = loadCachedProgram(vsSrc, fsSrc);
+    if(cached != 0) return cached;
+
+    GLuint vs = compileShader(GL_VERTEX_SHADER, vsSrc);
+    GLuint fs = compileShader(GL_FRAGMENT_SHADER, fsSrc);
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vs);
+    glAttachShader(program, fs);
+    if(programBinarySupported()) glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(program);
     GLint ok;
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &ok);
+    glGetProgramiv(program, GL_LINK_STATUS, &ok);
     if(!ok) {
         char buf[1024];
-        glGetProgramInfoLog(shaderProgram, 1024, nullptr, buf);
+        glGetProgramInfoLog(program, 1024, nullptr, buf);
         std::cerr << "Program link error: " << buf << std::endl;
     }
+    else {
+        storeCachedProgram(program, vsSrc, fsSrc);
+    }
     glDeleteShader(vs);
     glDeleteShader(fs);
+    return program;
+}
+
+void initGLResources() {
+    // compile shaders
+    shaderProgram = buildProgram(vertexShaderSrc, fragmentShaderSrc);
 
     // query uniform locations
     glUseProgram(shaderProgram);
     uni_uAlpha = glGetUniformLocation(shaderProgram, "uAlpha");
     uni_uPointSize = glGetUniformLocation(shaderProgram, "uPointSize");
     uni_uIsPoint = glGetUniformLocation(shaderProgram, "uIsPoint");
-    uni_uViewportSize = glGetUniformLocation(shaderProgram, "uViewportSize");
+    uni_uView = glGetUniformLocation(shaderProgram, "uView");
+    uni_uOrigin = glGetUniformLocation(shaderProgram, "uOrigin");
+    uni_uPositionScale = glGetUniformLocation(shaderProgram, "uPositionScale");
+    uni_uIsText = glGetUniformLocation(shaderProgram, "uIsText");
+    uni_uGlyphAtlas = glGetUniformLocation(shaderProgram, "uGlyphAtlas");
     // set sensible defaults
     if(uni_uAlpha != -1) glUniform1f(uni_uAlpha, 1.0f);
     if(uni_uPointSize != -1) glUniform1f(uni_uPointSize, 6.0f);
     if(uni_uIsPoint != -1) glUniform1i(uni_uIsPoint, 0);
-    if(uni_uViewportSize != -1) glUniform2f(uni_uViewportSize, currentWindowWidth, currentWindowHeight);
+    if(uni_uIsText != -1) glUniform1i(uni_uIsText, 0);
+    if(uni_uGlyphAtlas != -1) glUniform1i(uni_uGlyphAtlas, 0);
     glUseProgram(0);
 
-    // create VAO/VBO
+    // create VAO/VBO/IBO
     glGenVertexArrays(1, &vao);
     glGenBuffers(1, &vbo);
+    glGenBuffers(1, &ibo);
     glBindVertexArray(vao);
     glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
 
     // pre-allocate 1MB for streaming dynamic data to avoid frequent reallocations
     const size_t initialCapacity = 1024 * 1024; // bytes
     glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)initialCapacity, nullptr, GL_STREAM_DRAW);
     vboCapacityBytes = initialCapacity;
 
+    // 16-bit position only; scaled in the shader, so not normalized by GL
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_SHORT, GL_FALSE, sizeof(PackedVertex), (void*)0);
+    glDisableVertexAttribArray(1);
+
     // position (2 floats) + color (3 floats)
+    glGenVertexArrays(1, &interleavedVao);
+    glBindVertexArray(interleavedVao);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 5, (void*)0);
     glEnableVertexAttribArray(1);
     glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 5, (void*)(sizeof(float) * 2));
+
+    // position (2 floats) + color (3 floats) + atlas coordinates (2 floats)
+    glGenVertexArrays(1, &textVao);
+    glBindVertexArray(textVao);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 7, (void*)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 7, (void*)(sizeof(float) * 2));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 7, (void*)(sizeof(float) * 5));
     glBindVertexArray(0);
 
-    // Enable blending and multisampling/line smoothing to reduce pixelated appearance
+    // Enable blending; which anti-aliasing applies is decided per frame by the selected mode
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glEnable(GL_LINE_SMOOTH);
     glHint(GL_LINE_SMOOTH_HINT, GL_NICEST);
-    // Multisampling helps if the context supports it
+    // rasterization into the offscreen multisample target needs this
     glEnable(GL_MULTISAMPLE);
+    // strips inside one indexed draw are separated by restart markers
+    glEnable(GL_PRIMITIVE_RESTART);
+    glPrimitiveRestartIndex(PRIMITIVE_RESTART_INDEX);
+
+    initConicResources();
+    initGalleryResources();
+    initAntialiasingResources();
+    initBackgroundLayer();
+    initTextOverlay();
+    initTrailResources();
+    initIteratedPappusResources();
+    setRenderBackend(glRenderBackend());
 }
 
-// low-level helper: upload and draw one buffer as-is
-static void drawRawVertices(const std::vector<float>& data, GLenum mode) {
-    if(data.empty()) return;
-    glUseProgram(shaderProgram);
-    glBindVertexArray(vao);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+// grow the streaming VBO (bound to GL_ARRAY_BUFFER) when a frame needs more than its capacity
+static void ensureVboCapacity(size_t bytes) {
+    if(bytes <= vboCapacityBytes) return;
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)bytes, nullptr, GL_STREAM_DRAW);
+    vboCapacityBytes = bytes;
+}
 
-    size_t dataSizeBytes = data.size() * sizeof(float);
-    // If the preallocated buffer is large enough, stream the data with BufferSubData to avoid reallocations
-    if(dataSizeBytes <= vboCapacityBytes) {
-        glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)dataSizeBytes, data.data());
-    }
-    else {
-        // allocate larger buffer (grow) and update capacity
-        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)dataSizeBytes, data.data(), GL_STREAM_DRAW);
-        vboCapacityBytes = dataSizeBytes;
-    }
+// positions sent to the shader are relative to the view center
+static void setViewUniform(const ViewTransform& view) {
+    if(uni_uView == -1) return;
+    float m[9];
+    view.relativeMatrix(m);
+    glUniformMatrix3fv(uni_uView, 1, GL_FALSE, m);
+}
 
-    // set smoothing uniforms depending on primitive type
-    if(uni_uViewportSize != -1) {
-        glUniform2f(uni_uViewportSize, currentWindowWidth, currentWindowHeight);
-    }
+// set smoothing uniforms depending on primitive type
+static void setPrimitiveUniforms(GLenum mode) {
     if(uni_uIsPoint != -1) {
         if(mode == GL_POINTS) glUniform1i(uni_uIsPoint, 1);
         else glUniform1i(uni_uIsPoint, 0);
@@ -189,9 +207,32 @@ static void drawRawVertices(const std::vector<float>& data, GLenum mode) {
         // increase point size for better visibility and smoothing
         glUniform1f(uni_uPointSize, 6.0f);
     }
+}
+
+static_assert(PRIMITIVE_POINTS == GL_POINTS && PRIMITIVE_LINES == GL_LINES && PRIMITIVE_LINE_LOOP == GL_LINE_LOOP
+              && PRIMITIVE_LINE_STRIP == GL_LINE_STRIP, "primitive modes are passed to GL as they are");
 
-    GLsizei strideCount = (GLsizei)(data.size() / 5);
+// GL backend: upload and draw one buffer as-is
+static void drawVerticesGL(const float* data, size_t floatCount, PrimitiveMode mode, const ViewTransform& view) {
+    if(floatCount == 0) return;
+    glUseProgram(shaderProgram);
+    glBindVertexArray(interleavedVao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+
+    size_t dataSizeBytes = floatCount * sizeof(float);
+    ensureVboCapacity(dataSizeBytes);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)dataSizeBytes, data);
+
+    // plain world positions: the camera offset goes into the origin
+    setViewUniform(view);
+    setPrimitiveUniforms(mode);
+    if(uni_uOrigin != -1) glUniform2f(uni_uOrigin, (float)-view.centerX, (float)-view.centerY);
+    if(uni_uPositionScale != -1) glUniform1f(uni_uPositionScale, 1.0f);
+
+    GLsizei strideCount = (GLsizei)(floatCount / 5);
     glDrawArrays(mode, 0, strideCount);
+    renderStats.drawCalls++;
+    renderStats.verticesUploaded += strideCount;
 
     // reset point flag to avoid affecting subsequent draws
     if(uni_uIsPoint != -1) glUniform1i(uni_uIsPoint, 0);
@@ -200,70 +241,168 @@ static void drawRawVertices(const std::vector<float>& data, GLenum mode) {
     glUseProgram(0);
 }
 
-void drawVertices(const std::vector<float>& data, GLenum mode) {
-    if(data.empty()) return;
-    if(mode != GL_LINE_STRIP) {
-        drawRawVertices(data, mode);
-        return;
+
+void drawGlyphQuads(const float* data, size_t floatCount, const ViewTransform& view, GLuint atlas) {
+    if(floatCount == 0) return;
+    glUseProgram(shaderProgram);
+    glBindVertexArray(textVao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+
+    size_t dataSizeBytes = floatCount * sizeof(float);
+    ensureVboCapacity(dataSizeBytes);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)dataSizeBytes, data);
+
+    // the quads are built relative to the view center already
+    setViewUniform(view);
+    setPrimitiveUniforms(GL_TRIANGLES);
+    if(uni_uOrigin != -1) glUniform2f(uni_uOrigin, 0.0f, 0.0f);
+    if(uni_uPositionScale != -1) glUniform1f(uni_uPositionScale, 1.0f);
+    if(uni_uIsText != -1) glUniform1i(uni_uIsText, 1);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, atlas);
+
+    GLsizei vertexCount = (GLsizei)(floatCount / 7);
+    glDrawArrays(GL_TRIANGLES, 0, vertexCount);
+    renderStats.drawCalls++;
+    renderStats.verticesUploaded += vertexCount;
+
+    if(uni_uIsText != -1) glUniform1i(uni_uIsText, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindVertexArray(0);
+    glUseProgram(0);
+}
+
+static void drawIndexedRangesGL(const ViewTransform& view, const DrawRange* ranges, size_t rangeCount,
+                                const uint32_t* indices, size_t indexCount, const DrawBatch* batches, size_t batchCount) {
+    if(indexCount == 0) return;
+    glUseProgram(shaderProgram);
+    setViewUniform(view);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+
+    size_t totalBytes = 0;
+    for(size_t r = 0; r < rangeCount; r++) totalBytes += ranges[r].count * sizeof(PackedVertex);
+    ensureVboCapacity(totalBytes);
+    size_t offsetBytes = 0;
+    for(size_t r = 0; r < rangeCount; r++) {
+        size_t bytes = ranges[r].count * sizeof(PackedVertex);
+        glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)offsetBytes, (GLsizeiptr)bytes, ranges[r].data);
+        offsetBytes += bytes;
+        renderStats.verticesUploaded += ranges[r].count;
     }
 
-    const float splitThreshold = std::max(500.0f, (float)circleRadius * 2.0f);
-    size_t vertCount = data.size() / 5;
-    if(vertCount == 0) return;
-
-    std::vector<float> segment;
-    segment.reserve(5 * std::min((size_t)64, vertCount));
-
-    auto pushVert = [&](size_t idx){
-        segment.push_back(data[idx*5 + 0]);
-        segment.push_back(data[idx*5 + 1]);
-        segment.push_back(data[idx*5 + 2]);
-        segment.push_back(data[idx*5 + 3]);
-        segment.push_back(data[idx*5 + 4]);
-    };
-
-    // start with first vertex
-    pushVert(0);
-    for(size_t i = 1; i < vertCount; ++i) {
-        float x0 = data[(i-1)*5 + 0];
-        float y0 = data[(i-1)*5 + 1];
-        float x1 = data[i*5 + 0];
-        float y1 = data[i*5 + 1];
-        float dx = x1 - x0;
-        float dy = y1 - y0;
-        float dist = std::sqrt(dx*dx + dy*dy);
-
-        if(dist > splitThreshold) {
-            // draw current segment and start a new one
-            drawRawVertices(segment, GL_LINE_STRIP);
-            segment.clear();
-            // start new segment with this vertex
-            pushVert(i);
-        }
-        else {
-            // append vertex to current segment
-            pushVert(i);
-        }
+    // the element buffer binding is part of the VAO state
+    size_t indexBytes = indexCount * sizeof(GLuint);
+    if(indexBytes > iboCapacityBytes) {
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)indexBytes, indices, GL_STREAM_DRAW);
+        iboCapacityBytes = indexBytes;
+    }
+    else {
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, (GLsizeiptr)indexBytes, indices);
+    }
+
+    for(size_t b = 0; b < batchCount; b++) {
+        const DrawBatch& batch = batches[b];
+        setPrimitiveUniforms(batch.mode);
+        // subtracted in double, so what reaches the GPU stays small however deep the zoom
+        if(uni_uOrigin != -1) glUniform2f(uni_uOrigin, (float)(batch.originX - view.centerX), (float)(batch.originY - view.centerY));
+        if(uni_uPositionScale != -1) glUniform1f(uni_uPositionScale, batch.extent / QUANTIZATION_MAX);
+        glVertexAttrib3f(1, batch.color[0], batch.color[1], batch.color[2]);
+        glDrawElements(batches[b].mode, (GLsizei)batches[b].indexCount, GL_UNSIGNED_INT,
+                       (void*)(batches[b].firstIndex * sizeof(GLuint)));
+    }
+    renderStats.drawCalls += (int)batchCount;
+
+    if(uni_uIsPoint != -1) glUniform1i(uni_uIsPoint, 0);
+    glBindVertexArray(0);
+    glUseProgram(0);
+}
+
+class GlRenderBackend : public RenderBackend {
+public:
+    void drawVertices(const float* data, size_t floatCount, PrimitiveMode mode, const ViewTransform& view) override {
+        drawVerticesGL(data, floatCount, mode, view);
+    }
+    void drawIndexedRanges(const ViewTransform& view, const DrawRange* ranges, size_t rangeCount,
+                           const uint32_t* indices, size_t indexCount, const DrawBatch* batches, size_t batchCount) override {
+        drawIndexedRangesGL(view, ranges, rangeCount, indices, indexCount, batches, batchCount);
     }
+    const char* name() const override { return "gl"; }
+};
+
+RenderBackend& glRenderBackend() {
+    static GlRenderBackend backend;
+    return backend;
+}
+
+void drawVertices(const float* data, size_t floatCount, PrimitiveMode mode) {
+    activeRenderBackend().drawVertices(data, floatCount, mode, currentView());
+}
+
+void drawVertices(const std::vector<float>& data, PrimitiveMode mode) {
+    drawVertices(data.data(), data.size(), mode);
+}
+
+void drawIndexedRanges(const ViewTransform& view, const DrawRange* ranges, size_t rangeCount,
+                       const uint32_t* indices, size_t indexCount, const DrawBatch* batches, size_t batchCount) {
+    activeRenderBackend().drawIndexedRanges(view, ranges, rangeCount, indices, indexCount, batches, batchCount);
+}
+
+// base lines used to keep new points on their line, refreshed whenever a point is fixed
+static void updateBaseLines() {
+    for(int lineNumber = 0; lineNumber < 2; lineNumber++) {
+        if(collectedPoints < 2 + 3 * lineNumber) continue;
+        Vector3 p1, p2;
+        getLinePoints(3 * lineNumber, p1, p2, circleRadius);
+
+        if(p1[2] < infinityThreshold && p2[2] < infinityThreshold) {
+            isIdealLine[lineNumber] = true;
+        }
 
-    if(!segment.empty()) drawRawVertices(segment, GL_LINE_STRIP);
+        baseLines[lineNumber] = GreatCircle::through(p1, p2);
+    }
 }
 
 Vector3 putPointInRealLine(double distanceX, double distanceY, int offsetX, int offsetY, int lineNumber) {
-    distanceX -= offsetX;
-    distanceY -= offsetY;
-    auto [zRotationAngle, direction] = lineBaseRotations[lineNumber];
-    Vector3 lineLocalDistances = Matrix3::rotationZCos(zRotationAngle, !direction) * Vector3(distanceX, distanceY, 0);
-    distanceX = lineLocalDistances[0];
-    distanceY = lineLocalDistances[1];
-    if(abs(distanceX) > circleRadius) {
-        distanceX = circleRadius;
+    return baseLines[lineNumber].project(distanceX - offsetX, distanceY - offsetY, circleRadius);
+}
+
+// world position moved onto the base line drawn on the disk centered at (offsetX, offsetY)
+static Vector3 pointOnBaseLine(double distanceX, double distanceY, int offsetX, int offsetY, int lineNumber) {
+    if(isIdealLine[lineNumber]) {
+        distanceX = (distanceX - offsetX) * circleRadius;
+        distanceY = (distanceY - offsetY) * circleRadius;
+        capDistance2D(distanceX, distanceY);
+        return Vector3(distanceX, distanceY, 0);
     }
-    distanceY = sqrt(pow(circleRadius, 2) - pow(distanceX, 2));
-    return lineTransformations[lineNumber] * Vector3(distanceX, distanceY, 0);
+    return putPointInRealLine(distanceX, distanceY, offsetX, offsetY, lineNumber);
 }
 
+// right-drag panning: last pointer position while the button is held
+static bool panning = false;
+static int panLastX = 0, panLastY = 0;
+
 void mouseClickCallback(int button, int state, int mouseX, int mouseY) {
+    // freeglut reports the wheel as buttons 3 (up) and 4 (down)
+    if((button == 3 || button == 4) && state == GLUT_DOWN) {
+        zoomCameraAt(mouseX, mouseY, button == 3 ? CAMERA_ZOOM_STEP : 1.0 / CAMERA_ZOOM_STEP);
+        return;
+    }
+    if(button == GLUT_RIGHT_BUTTON) {
+        panning = state == GLUT_DOWN;
+        panLastX = mouseX;
+        panLastY = mouseY;
+        return;
+    }
+    if(button == GLUT_LEFT_BUTTON && state == GLUT_DOWN && extraPointMode && extraCandidateLine != -1) {
+        int& count = extraPointCount[extraCandidateLine];
+        if(count < MAX_EXTRA_POINTS) {
+            extraPoints[extraCandidateLine][count++] = extraCandidate;
+            extraPointsVersion++;
+            publishInput();
+        }
+        return;
+    }
     if(button == GLUT_LEFT_BUTTON && state == GLUT_DOWN) {
         if(collectedPoints < 3) {
             bool allPointsDifferent = true;
@@ -297,11 +436,21 @@ void mouseClickCallback(int button, int state, int mouseX, int mouseY) {
                 collectedPoints++;
             }
         }
-        glutPostRedisplay();
+        updateBaseLines();
+        publishInput();
     }
 }
 
+// point bound to a base line, moved to a nearby feature when snapping finds one
+static Vector3 snappedOnBaseLine(Vector3 pointInLine, int offsetX, int offsetY, int lineNumber) {
+    double snapX = pointInLine[0], snapY = pointInLine[1];
+    if(!snapOnBaseLine(lineNumber, snapX, snapY)) return pointInLine;
+    return pointOnBaseLine(snapX + offsetX, snapY + offsetY, offsetX, offsetY, lineNumber);
+}
+
 void passiveMouseMotion(int x, int y) {
+    // only what changed since the last event is reindexed
+    updateSnapFeatures();
     if(collectedPoints < 6) {
         mouseToWorldCoords(x, y, worldX, worldY);
         double distanceX = worldX;
@@ -309,6 +458,7 @@ void passiveMouseMotion(int x, int y) {
         if(collectedPoints < 2) {
             distanceX -= offsetCircle1X;
             distanceY -= offsetCircle1Y;
+            snapFreePoint(0, distanceX, distanceY);
             capDistance2D(distanceX, distanceY);
             markedPoints[collectedPoints] = std::make_tuple(
                 distanceX,
@@ -323,6 +473,7 @@ void passiveMouseMotion(int x, int y) {
         else if(collectedPoints > 2 && collectedPoints < 5) {
             distanceX -= offsetCircle2X;
             distanceY -= offsetCircle2Y;
+            snapFreePoint(1, distanceX, distanceY);
             capDistance2D(distanceX, distanceY);
             markedPoints[collectedPoints] = std::make_tuple(
                 distanceX,
@@ -347,15 +498,8 @@ void passiveMouseMotion(int x, int y) {
                 offsetX = offsetCircle2X;
                 offsetY = offsetCircle2Y;
             }
-            if(isIdealLine[lineNumber]) {
-                distanceX = (distanceX - offsetX) * circleRadius;
-                distanceY = (distanceY - offsetY) * circleRadius;
-                capDistance2D(distanceX, distanceY);
-                pointInLine = Vector3(distanceX, distanceY, 0);
-            }
-            else {
-                pointInLine = putPointInRealLine(distanceX, distanceY, offsetX, offsetY, lineNumber);
-            }
+            pointInLine = pointOnBaseLine(distanceX, distanceY, offsetX, offsetY, lineNumber);
+            pointInLine = snappedOnBaseLine(pointInLine, offsetX, offsetY, lineNumber);
             markedPoints[collectedPoints] = std::make_tuple(
                 pointInLine[0],
                 pointInLine[1],
@@ -367,58 +511,110 @@ void passiveMouseMotion(int x, int y) {
             targetMarkedY[collectedPoints] = pointInLine[1];
         }
         drawablePoints = collectedPoints + 1;
-        glutPostRedisplay();
+        noteMotion();
+        publishInput();
     }
     else {
         mouseToWorldCoords(x, y, worldX, worldY);
         double distanceX = worldX;
         double distanceY = worldY;
-        Vector3 pointInLine;
-        if(isIdealLine[0]) {
-            distanceX = (distanceX - offsetCircle1X) * circleRadius;
-            distanceY = (distanceY - offsetCircle1Y) * circleRadius;
-            capDistance2D(distanceX, distanceY);
-            pointInLine = Vector3(distanceX, distanceY, 0);
-        }
-        else {
-            pointInLine = putPointInRealLine(distanceX, distanceY, offsetCircle1X, offsetCircle1Y, 0);
+        if(extraPointMode) {
+            // the candidate goes on the line of the nearer disk
+            int lineNumber = calcNorm2d(distanceX - offsetCircle1X, distanceY - offsetCircle1Y)
+                           <= calcNorm2d(distanceX - offsetCircle2X, distanceY - offsetCircle2Y) ? 0 : 1;
+            int offsetX = lineNumber == 0 ? offsetCircle1X : offsetCircle2X;
+            int offsetY = lineNumber == 0 ? offsetCircle1Y : offsetCircle2Y;
+            Vector3 pointInLine = snappedOnBaseLine(pointOnBaseLine(distanceX, distanceY, offsetX, offsetY, lineNumber),
+                                                    offsetX, offsetY, lineNumber);
+            extraCandidate = std::make_tuple(pointInLine[0], pointInLine[1]);
+            extraCandidateLine = lineNumber;
+            publishInput();
+            return;
         }
+        Vector3 pointInLine = snappedOnBaseLine(pointOnBaseLine(distanceX, distanceY, offsetCircle1X, offsetCircle1Y, 0),
+                                                offsetCircle1X, offsetCircle1Y, 0);
         // update raw interactive point (used for computations)
         interactivePoint = std::make_tuple(pointInLine[0], pointInLine[1]);
         canDrawInteractivePoint = true;
         // update render target for interactive point (display-only)
         targetInteractiveX = pointInLine[0];
         targetInteractiveY = pointInLine[1];
-        glutPostRedisplay();
+        noteMotion();
+        publishInput();
     }
 }
 
+void toggleExtraPointMode() {
+    if(collectedPoints < 6) return;
+    extraPointMode = !extraPointMode;
+    extraCandidateLine = -1;
+    printf("extra points %s: %d on the first line, %d on the second\n",
+           extraPointMode ? "on" : "off", extraPointCount[0], extraPointCount[1]);
+    publishInput();
+}
 
-std::tuple<double, bool, double> calculateRotations(std::tuple<Vector3, Vector3> line) {
-    auto [p1, p2] = line;
-    Vector3 lineVector = p1.cross(p2);
-
-    if(lineVector[0] == 0 && lineVector[1] == 0) {
-        return std::make_tuple(1, false, 0);
+void generateExtraPoints() {
+    if(collectedPoints < 6) return;
+    // as many new pairs as the lines already have, so N doubles
+    Vector3 xs[3], ys[3];
+    for(int k = 0; k < 3; k++) {
+        xs[k] = liftToSphere(std::get<0>(markedPoints[k]), std::get<1>(markedPoints[k]), circleRadius);
+        ys[k] = liftToSphere(std::get<0>(markedPoints[3 + k]), std::get<1>(markedPoints[3 + k]), circleRadius);
     }
-
-    if(lineVector[2] < 0) {
-        lineVector = lineVector * -1;
+    PappusConfiguration config = computePappus(xs, ys);
+    static std::mt19937 rng(7);
+    std::uniform_real_distribution<double> angle(0.0, M_PI);
+    // the fit pairs x_i with y_i: a point clicked on one line without its partner is dropped
+    int count = std::min(extraPointCount[0], extraPointCount[1]);
+    int target = std::min(MAX_EXTRA_POINTS, 3 + 2 * count);
+    for(; count < target; count++) {
+        // y = the image of x under the correspondence, so the new pairs lie on the exact axis
+        double t = angle(rng);
+        Vector3 x = (baseLines[0].u() * cos(t) + baseLines[0].v() * sin(t)) * circleRadius;
+        Vector3 y = pappusImage(config, x).image;
+        extraPoints[0][count] = std::make_tuple(x[0], x[1]);
+        extraPoints[1][count] = std::make_tuple(y[0], y[1]);
     }
+    extraPointCount[0] = extraPointCount[1] = count;
+    extraPointsVersion++;
+    publishInput();
+}
 
-    Vector3 infinityPoint = Vector3(-lineVector[1], lineVector[0], 0).normalize();
-
-    double zRotationAngle = infinityPoint.dot(Vector3(1, 0, 0));
-    bool clockwise = (infinityPoint[1] < 0);
-
-    double xRotationAngle = (lineVector.cross(infinityPoint).normalize())[2];
+void mouseDragCallback(int x, int y) {
+    if(!panning) return;
+    panCamera(x - panLastX, y - panLastY);
+    panLastX = x;
+    panLastY = y;
+}
 
-    return std::make_tuple(zRotationAngle, clockwise, xRotationAngle);
+// HUD text for the frame just finished: build and submit time, draw calls and vertices uploaded
+static RenderStats lastFrameStats;
+static double lastBuildMs = 0.0, lastSubmitMs = 0.0;
+static void formatHud(char* hud, size_t size) {
+    snprintf(hud, size, "frame %.2f ms  build %.2f  submit %.2f\ndraws %d  vertices %zu",
+             lastBuildMs + lastSubmitMs, lastBuildMs, lastSubmitMs,
+             lastFrameStats.drawCalls, lastFrameStats.verticesUploaded);
 }
 
 // ---- Display ----
 void display(void) {
-    glClear(GL_COLOR_BUFFER_BIT);
+    lastFrameStats = renderStats;
+    renderStats = RenderStats();
+    markDrawStreamFrame();
+    char hud[128];
+    formatHud(hud, sizeof hud);
+    beginAntialiasedFrame();
+
+    if(galleryMode) {
+        drawGallery();
+        formatGalleryHud(hud, sizeof hud);
+        drawTextOverlay(nullptr, 0, currentView(), hud);
+        endAntialiasedFrame();
+        captureFrame(0);
+        glFlush();
+        noteFramePresented(true);
+        return;
+    }
 
     // initialize smoothing targets/draw positions on first frame
     if(!smoothingInitialized) {
@@ -442,318 +638,47 @@ void display(void) {
     }
     drawInteractiveX += (targetInteractiveX - drawInteractiveX) * smoothingFactor;
 
-    std::vector<float> buffer; // interleaved x,y,r,g,b
-
-    float x, y, vx, vy;
-    Vector3 localCoordPoint;
-    Vector3 globalCoordPoint;
-
-    // draw first circle (dark gray)
-    for(float i = 0; i < 2 * M_PI; i += 0.001) {
-        x = (circleRadius * cos(i)) + offsetCircle1X;
-        y = (circleRadius * sin(i)) + offsetCircle1Y;
-        buffer.push_back(x);
-        buffer.push_back(y);
-        buffer.push_back(0.4f);
-        buffer.push_back(0.4f);
-        buffer.push_back(0.4f);
-    }
-    drawVertices(buffer, GL_LINE_STRIP);
-    buffer.clear();
-
-    // draw line 1 projected onto first circle
-    if(collectedPoints >= 2) {
-        Vector3 p1, p2;
-        getLinePoints(0, p1, p2, circleRadius);
-
-        if(p1[2] < infinityThreshold && p2[2] < infinityThreshold) {
-            isIdealLine[0] = true;
-        }
-
-        auto [zRotationAngle, clockwise, xRotationAngle] = calculateRotations({p1, p2});
-        lineTransformations[0] = Matrix3::rotationZCos(zRotationAngle, clockwise) * Matrix3::rotationXSin(xRotationAngle);
-        lineBaseRotations[0] = std::make_tuple(zRotationAngle, clockwise);
-
-        drawProjectedLine(lineTransformations[0], offsetCircle1X, offsetCircle1Y, circleRadius, xRotationAngle, Vector3(1,1,1));
-
-
-    }
-
-    // draw second circle
-    for(float i = 0; i < 2 * M_PI; i += 0.001) {
-        x = (circleRadius * cos(i)) + offsetCircle2X;
-        y = (circleRadius * sin(i)) + offsetCircle2Y;
-        buffer.push_back(x);
-        buffer.push_back(y);
-        buffer.push_back(0.4f);
-        buffer.push_back(0.4f);
-        buffer.push_back(0.4f);
-    }
-    drawVertices(buffer, GL_LINE_STRIP);
-    buffer.clear();
-
-    // draw line 2 projected onto second circle
-    if(collectedPoints >= 5) {
-        Vector3 p1, p2;
-        getLinePoints(3, p1, p2, circleRadius);
-
-        if(p1[2] < infinityThreshold && p2[2] < infinityThreshold) {
-            isIdealLine[1] = true;
-        }
-
-        auto [zRotationAngle, clockwise, xRotationAngle] = calculateRotations({p1, p2});
-        lineTransformations[1] = Matrix3::rotationZCos(zRotationAngle, clockwise) * Matrix3::rotationXSin(xRotationAngle);
-        lineBaseRotations[1] = std::make_tuple(zRotationAngle, clockwise);
-
-       drawProjectedLine(lineTransformations[1], offsetCircle2X, offsetCircle2Y, circleRadius, xRotationAngle, Vector3(1,1,1));
+    // geometry comes ready from the compute stage, only submission happens here
+    const SceneSnapshot& scene = acquireLatestScene();
+    updateSnapAxis(scene.backgroundKey, scene.hasAxis, scene.axis);
+    uint64_t allocationsBefore = heapAllocationCount();
+    auto submitStart = std::chrono::steady_clock::now();
+    // a recorded stream holds the whole scene in every frame, not only when the layer changes
+    if(backgroundLayerStale(scene.backgroundKey) || recordingDrawStream()) {
+        beginBackgroundLayer();
+        scene.background.submit();
+        drawConics(scene.background.conics, scene.background.view);
+        endBackgroundLayer(scene.backgroundKey);
     }
-
-    int pointOrder;
-    // draw marked points
-     for(int j = 0; j < drawablePoints; j++) {
-         // restored original per-index channel variation but with a different base palette
-         float rgbValues[3] = {0.85f, 0.85f, 0.85f};
-         rgbValues[j % 3] = 0.15f; // lower one channel to create distinct color per correspondence
-         float redValue = rgbValues[0];
-         float greenValue = rgbValues[1];
-         float blueValue = rgbValues[2];
-         auto[px, py, offsetCircleX, offsetCircleY] = markedPoints[j];
-        std::vector<float> ptBuf;
-        std::vector<float> ptOppBuf;
-        if(checkInfinityPoint(px, py)) {
-            for(float i = 0; i < 2 * M_PI; i += 0.001) {
-                float pxCircle = (7 * cos(i)) - px + offsetCircleX;
-                float pyCircle = (7 * sin(i)) - py + offsetCircleY;
-                ptOppBuf.push_back(pxCircle);
-                ptOppBuf.push_back(pyCircle);
-                ptOppBuf.push_back(redValue);
-                ptOppBuf.push_back(greenValue);
-                ptOppBuf.push_back(blueValue);
-            }
-        }
-        for(float i = 0; i < 2 * M_PI; i += 0.001) {
-            float pxCircle = (7 * cos(i)) + px + offsetCircleX;
-            float pyCircle = (7 * sin(i)) + py + offsetCircleY;
-            ptBuf.push_back(pxCircle);
-            ptBuf.push_back(pyCircle);
-            ptBuf.push_back(redValue);
-            ptBuf.push_back(greenValue);
-            ptBuf.push_back(blueValue);
-        }
-        drawVertices(ptBuf, GL_LINE_STRIP);
-        if(!ptOppBuf.empty()) drawVertices(ptOppBuf, GL_LINE_STRIP);
-     }
-
-    if(collectedPoints >= 6){
-        // all points on the sphere
-        Vector3 x1 = liftToSphere(std::get<0>(markedPoints[0]), std::get<1>(markedPoints[0]), circleRadius);
-        Vector3 x2 = liftToSphere(std::get<0>(markedPoints[1]), std::get<1>(markedPoints[1]), circleRadius);
-        Vector3 x3 = liftToSphere(std::get<0>(markedPoints[2]), std::get<1>(markedPoints[2]), circleRadius);
-        Vector3 y1 = liftToSphere(std::get<0>(markedPoints[3]), std::get<1>(markedPoints[3]), circleRadius);
-        Vector3 y2 = liftToSphere(std::get<0>(markedPoints[4]), std::get<1>(markedPoints[4]), circleRadius);
-        Vector3 y3 = liftToSphere(std::get<0>(markedPoints[5]), std::get<1>(markedPoints[5]), circleRadius);
-        
-        
-        // all lines between points (necessary for pappus line)
-        Vector3 x1y2 = x1.cross(y2);
-        Vector3 x2y1 = x2.cross(y1);
-        Vector3 x1y3 = x1.cross(y3);
-        Vector3 x3y1 = x3.cross(y1);
-        Vector3 x2y3 = x2.cross(y3);
-        Vector3 y2x3 = y2.cross(x3);
-
-
-        Vector3 intersect1 = lineIntersection(x1y2, x2y1);
-        Vector3 intersect2 = lineIntersection(x1y3, x3y1);
-        Vector3 intersect3 = lineIntersection(x2y3, y2x3);
-        Vector3 pappus;
-
-        Vector3 chosen1 = intersect1;
-        Vector3 chosen2 = intersect2;
-        if (checkLinePointsDifferent(intersect1, intersect2)) {
-            pappus = intersect1.cross(intersect2);
-        } else {
-            chosen2 = intersect3;
-            pappus = intersect1.cross(intersect3);
-        }
-
-        
-        // Draw supporting lines if enabled (S key toggle)
-        if(showSupportingLines) {
-            // Draw x1y2
-            {
-                auto [zRotationAngle, clockwise, xRotationAngle] = calculateRotations({x1, y2});
-                Matrix3 transform = Matrix3::rotationZCos(zRotationAngle, clockwise) * Matrix3::rotationXSin(xRotationAngle);
-                drawProjectedLine(transform, offsetCircle1X, offsetCircle1Y, circleRadius, xRotationAngle);
-                drawProjectedLine(transform, offsetCircle2X, offsetCircle2Y, circleRadius, xRotationAngle);
-            }
-
-            // Draw x2y1
-            {
-                auto [zRotationAngle, clockwise, xRotationAngle] = calculateRotations({y1, x2});
-                Matrix3 transform = Matrix3::rotationZCos(zRotationAngle, clockwise) * Matrix3::rotationXSin(xRotationAngle);
-                drawProjectedLine(transform, offsetCircle1X, offsetCircle1Y, circleRadius, xRotationAngle);
-                drawProjectedLine(transform, offsetCircle2X, offsetCircle2Y, circleRadius, xRotationAngle);
-            }
-
-            // Draw x3y1
-            {
-                auto [zRotationAngle, clockwise, xRotationAngle] = calculateRotations({x3, y1});
-                Matrix3 transform = Matrix3::rotationZCos(zRotationAngle, clockwise) * Matrix3::rotationXSin(xRotationAngle);
-                drawProjectedLine(transform, offsetCircle1X, offsetCircle1Y, circleRadius, xRotationAngle);
-                drawProjectedLine(transform, offsetCircle2X, offsetCircle2Y, circleRadius, xRotationAngle);
-            }
-
-            // Draw y3x1
-            {
-                auto [zRotationAngle, clockwise, xRotationAngle] = calculateRotations({y3, x1});
-                Matrix3 transform = Matrix3::rotationZCos(zRotationAngle, clockwise) * Matrix3::rotationXSin(xRotationAngle);
-                drawProjectedLine(transform, offsetCircle1X, offsetCircle1Y, circleRadius, xRotationAngle);
-                drawProjectedLine(transform, offsetCircle2X, offsetCircle2Y, circleRadius, xRotationAngle);
-            }
-
-            // Draw x2y3
-            {
-                auto [zRotationAngle, clockwise, xRotationAngle] = calculateRotations({x2, y3});
-                Matrix3 transform = Matrix3::rotationZCos(zRotationAngle, clockwise) * Matrix3::rotationXSin(xRotationAngle);
-                drawProjectedLine(transform, offsetCircle1X, offsetCircle1Y, circleRadius, xRotationAngle);
-                drawProjectedLine(transform, offsetCircle2X, offsetCircle2Y, circleRadius, xRotationAngle);
-            }
-
-            // Draw y2x3
-            {
-                auto [zRotationAngle, clockwise, xRotationAngle] = calculateRotations({y2, x3});
-                Matrix3 transform = Matrix3::rotationZCos(zRotationAngle, clockwise) * Matrix3::rotationXSin(xRotationAngle);
-                drawProjectedLine(transform, offsetCircle1X, offsetCircle1Y, circleRadius, xRotationAngle);
-                drawProjectedLine(transform, offsetCircle2X, offsetCircle2Y, circleRadius, xRotationAngle);
-            }
-        }
-
-    
-
-        //draw pappus
-
-
-        auto [zRotationAngle, clockwise, xRotationAngle] = calculateRotations({chosen1, chosen2});
-        Matrix3 transform = Matrix3::rotationZCos(zRotationAngle, clockwise) * Matrix3::rotationXSin(xRotationAngle);
-        std::tuple<double, bool> rotate = std::make_tuple(zRotationAngle, clockwise);
-
-        // draw only the arc (no opposite-side vertices) for pappus support lines
-        drawProjectedLine(transform, offsetCircle1X, offsetCircle1Y, circleRadius, true, Vector3(0.5,1,0.5));
-        drawProjectedLine(transform, offsetCircle2X, offsetCircle2Y, circleRadius, true, Vector3(0.5,1,0.5));
-
-        //draw interactive point
-         if (canDrawInteractivePoint) {
-             auto[px, py] = interactivePoint;
-             // interactive point circle on first circle (green)
-            std::vector<float> itpBuf;
-            std::vector<float> itpOppBuf;
-            if(checkInfinityPoint(px, py)) {
-                for(float i = 0; i < 2 * M_PI; i += 0.001) {
-                    float pxCircle = (7 * cos(i)) - px + offsetCircle1X;
-                    float pyCircle = (7 * sin(i)) - py + offsetCircle1Y;
-                    itpOppBuf.push_back(pxCircle);
-                    itpOppBuf.push_back(pyCircle);
-                    itpOppBuf.push_back(0.0f); // green R
-                    itpOppBuf.push_back(1.0f); // green G
-                    itpOppBuf.push_back(0.0f); // green B
-                }
-            }
-            for(float i = 0; i < 2 * M_PI; i += 0.001) {
-                float pxCircle = (7 * cos(i)) + px + offsetCircle1X;
-                float pyCircle = (7 * sin(i)) + py + offsetCircle1Y;
-                itpBuf.push_back(pxCircle);
-                itpBuf.push_back(pyCircle);
-                itpBuf.push_back(0.0f); // green R
-                itpBuf.push_back(1.0f); // green G
-                itpBuf.push_back(0.0f); // green B
-            }
-            drawVertices(itpBuf, GL_LINE_STRIP);
-            if(!itpOppBuf.empty()) drawVertices(itpOppBuf, GL_LINE_STRIP);
-
-            Vector3 chosenpoint1 = y1;
-            Vector3 chosenpoint2 = x1;
-            if (checkInfinityPoint(y1[0], y1[1]) && checkInfinityPoint(x1[0], x1[1])) {
-                chosenpoint1 = y2;
-                chosenpoint2 = x2;
-            }
-        
-            // draw the image point and related projected lines
-            Vector3 imageLine = y2.cross(y3);
-            Vector3 itp = liftToSphere(px, py, circleRadius);
-            Vector3 firstCorrrespondenceLine = chosenpoint1.cross(itp);
-
-            Vector3 pappusIntersection = lineIntersection(pappus, firstCorrrespondenceLine);
-            Vector3 secondCorrrespondenceLine = chosenpoint2.cross(pappusIntersection);
-
-            Vector3 imagePoint = lineIntersection(imageLine, secondCorrrespondenceLine);
-            if(imagePoint[2] < 0) imagePoint = imagePoint * -1;
-            if(pappusIntersection[2] < 0) pappusIntersection = pappusIntersection * -1;
-
-            // projected line from chosenpoint1 to itp on circle1
-            {
-                auto [zR, cw, xR] = calculateRotations({chosenpoint1, itp});
-                Matrix3 tr = Matrix3::rotationZCos(zR, cw) * Matrix3::rotationXSin(xR);
-                drawProjectedLine(tr, offsetCircle1X, offsetCircle1Y, circleRadius, xR, Vector3(0.5,0.5,1));
-            }
-
-            // projected line for pappusIntersection -> imagePoint on circle2
-            {
-                auto [zR2, cw2, xR2] = calculateRotations({pappusIntersection, imagePoint});
-                Matrix3 tr2 = Matrix3::rotationZCos(zR2, cw2) * Matrix3::rotationXSin(xR2);
-                drawProjectedLine(tr2, offsetCircle2X, offsetCircle2Y, circleRadius, xR2, Vector3(0.5,0.5,1));
-            }
-
-            // draw pappus intersection marker circles on both circles (dark gray)
-             {
-                 auto [rx, ry, rz] = pappusIntersection;
-                std::vector<float> papNegBuf;
-                std::vector<float> papPosBuf;
-                if(checkInfinityPoint(rx, ry)) {
-                    for(float i = 0; i < 2 * M_PI; i += 0.001) {
-                        float pxCircle1 = (7 * cos(i)) - rx + offsetCircle1X;
-                        float pyCircle1 = (7 * sin(i)) - ry + offsetCircle1Y;
-                        float pxCircle2 = (7 * cos(i)) - rx + offsetCircle2X;
-                        float pyCircle2 = (7 * sin(i)) - ry + offsetCircle2Y;
-                        papNegBuf.push_back(pxCircle1); papNegBuf.push_back(pyCircle1); papNegBuf.push_back(0.1f); papNegBuf.push_back(0.1f); papNegBuf.push_back(0.1f);
-                        papNegBuf.push_back(pxCircle2); papNegBuf.push_back(pyCircle2); papNegBuf.push_back(0.1f); papNegBuf.push_back(0.1f); papNegBuf.push_back(0.1f);
-                    }
-                }
-                for(float i = 0; i < 2 * M_PI; i += 0.001) {
-                    float pxCircle1 = (7 * cos(i)) + rx + offsetCircle1X;
-                    float pyCircle1 = (7 * sin(i)) + ry + offsetCircle1Y;
-                    float pxCircle2 = (7 * cos(i)) + rx + offsetCircle2X;
-                    float pyCircle2 = (7 * sin(i)) + ry + offsetCircle2Y;
-                    papPosBuf.push_back(pxCircle1); papPosBuf.push_back(pyCircle1); papPosBuf.push_back(0.1f); papPosBuf.push_back(0.1f); papPosBuf.push_back(0.1f);
-                    papPosBuf.push_back(pxCircle2); papPosBuf.push_back(pyCircle2); papPosBuf.push_back(0.1f); papPosBuf.push_back(0.1f); papPosBuf.push_back(0.1f);
-                }
-                if(!papPosBuf.empty()) drawVertices(papPosBuf, GL_LINE_STRIP);
-                if(!papNegBuf.empty()) drawVertices(papNegBuf, GL_LINE_STRIP);
-             }
-
-            // draw image point on second circle (use same orange as interactive point)
-             {
-                 auto [qx, qy, qz] = imagePoint;
-                std::vector<float> imgPosBuf;
-                std::vector<float> imgNegBuf;
-                if(checkInfinityPoint(qx, qy)) {
-                    for(float i = 0; i < 2 * M_PI; i += 0.001) {
-                        float pxCircle = (7 * cos(i)) - qx + offsetCircle2X;
-                        float pyCircle = (7 * sin(i)) - qy + offsetCircle2Y;
-                        // green to match interactive point
-                        imgNegBuf.push_back(pxCircle); imgNegBuf.push_back(pyCircle); imgNegBuf.push_back(0.0f); imgNegBuf.push_back(1.0f); imgNegBuf.push_back(0.0f);
-                    }
-                }
-                for(float i = 0; i < 2 * M_PI; i += 0.001) {
-                    float pxCircle = (7 * cos(i)) + qx + offsetCircle2X;
-                    float pyCircle = (7 * sin(i)) + qy + offsetCircle2Y;
-                    imgPosBuf.push_back(pxCircle); imgPosBuf.push_back(pyCircle); imgPosBuf.push_back(0.0f); imgPosBuf.push_back(1.0f); imgPosBuf.push_back(0.0f);
-                }
-                if(!imgPosBuf.empty()) drawVertices(imgPosBuf, GL_LINE_STRIP);
-                if(!imgNegBuf.empty()) drawVertices(imgNegBuf, GL_LINE_STRIP);
-             }
-        }
+    compositeBackgroundLayer();
+    // a new entry whenever the interactive point has moved, not on every published input
+    static double trailLast[4] = {};
+    if(showTrail && scene.hasCorrespondence && !std::equal(trailLast, trailLast + 4, scene.correspondence)) {
+        appendTrail(scene.correspondence[0], scene.correspondence[1], scene.correspondence[2], scene.correspondence[3]);
+        std::copy(scene.correspondence, scene.correspondence + 4, trailLast);
     }
-
+    drawTrail(scene.geometry.view);
+    drawIteratedPappus(scene.geometry.view);
+    scene.geometry.submit();
+    drawConics(scene.geometry.conics, scene.geometry.view);
+    drawTextOverlay(scene.labels, scene.labelCount, scene.geometry.view, hud);
+    endAntialiasedFrame();
+    captureFrame(scene.inputSequence);
     glFlush();
+    double submitMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - submitStart).count();
+    recordFrameTime(scene.qualityLevel, scene.buildMs + submitMs);
+    lastBuildMs = scene.buildMs;
+    lastSubmitMs = submitMs;
+    postHemisphereRedisplay();
+    // the scene is empty until the compute stage delivered its first build
+    noteFramePresented(scene.inputSequence != 0);
+    if(showAllocationStats) {
+        // submit counts include anything the GL driver allocates on this thread or others
+        printf("frame %llu: build %llu heap allocations, submit %llu, arena %zu/%zu KB, conics tessellated %d background + %d foreground\n",
+               (unsigned long long)scene.inputSequence,
+               (unsigned long long)scene.buildAllocations,
+               (unsigned long long)(heapAllocationCount() - allocationsBefore),
+               scene.geometry.arena.used() / 1024, scene.geometry.arena.capacity() / 1024,
+               scene.background.conics.dropped, scene.geometry.conics.dropped);
+    }
 }
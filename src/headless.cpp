@@ -0,0 +1,36 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "computeServer.h"
+#include "cpuRasterizer.h"
+#include "utils.h"
+
+int runHeadlessCommand(int argc, char** argv) {
+    if(argc > 1 && strcmp(argv[1], "--serve") == 0) {
+        return runComputeServer(stdin, stdout);
+    }
+    if(argc > 2 && strcmp(argv[1], "--pack") == 0) {
+        return runDatasetPack(stdin, argv[2]);
+    }
+    if(argc > 3 && strcmp(argv[1], "--compute") == 0) {
+        int shard = 0, shardCount = 1;
+        if(argc > 4 && (sscanf(argv[4], "%d/%d", &shard, &shardCount) != 2 || shardCount < 1 || shard < 0 || shard >= shardCount)) {
+            fprintf(stderr, "Shard must be given as index/count, e.g. 0/4\n");
+            return 1;
+        }
+        return runDatasetCompute(argv[2], argv[3], shard, shardCount);
+    }
+    if(argc > 2 && strcmp(argv[1], "--render") == 0) {
+        int width = INITIAL_WINDOW_WIDTH, height = INITIAL_WINDOW_HEIGHT;
+        if(argc > 4) {
+            width = atoi(argv[3]);
+            height = atoi(argv[4]);
+        }
+        if(width < 1 || height < 1) {
+            fprintf(stderr, "Render size must be positive\n");
+            return 1;
+        }
+        return runHeadlessRender(stdin, argv[2], width, height);
+    }
+    return -1;
+}
@@ -0,0 +1,148 @@
+#include <GL/glew.h>
+#include <GL/glut.h>
+#include <GL/freeglut_ext.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include "hemisphereView.h"
+#include "graphics.h"
+#include "renderBackend.h"
+#include "utils.h"
+
+// 0 until the window is first opened, and again after it is closed
+static int hemisphereWindow = 0;
+static int mainWindow = 0;
+static bool hemisphereVisible = false;
+static int windowWidth = HEMISPHERE_WINDOW_SIZE, windowHeight = HEMISPHERE_WINDOW_SIZE;
+// spin about the sphere's own axis, then tilt towards the viewer
+static double yaw = 0.0, pitch = -1.0;
+static int dragX = 0, dragY = 0;
+static bool dragging = false;
+
+static GLint uni_uLift = -1;
+static GLint uni_uRotation = -1;
+static GLint uni_uDisk1 = -1, uni_uDisk2 = -1;
+static GLint uni_uRadius = -1;
+
+// column-major rotation about x by pitch after rotation about z by yaw
+static void rotationMatrix(float m[9]) {
+    double cy = std::cos(yaw), sy = std::sin(yaw);
+    double cp = std::cos(pitch), sp = std::sin(pitch);
+    float columns[9] = {
+        (float)cy, (float)(cp * sy), (float)(sp * sy),
+        (float)-sy, (float)(cp * cy), (float)(sp * cy),
+        0.0f, (float)-sp, (float)cp
+    };
+    std::copy(columns, columns + 9, m);
+}
+
+static void displayHemisphere() {
+    const SceneSnapshot& scene = currentScene();
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, windowWidth, windowHeight);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    // the home view of the world, both disks in sight whatever the main camera does
+    ViewTransform view = viewTransform(Camera(), windowWidth, windowHeight);
+    float rotation[9];
+    rotationMatrix(rotation);
+    glUseProgram(shaderProgram);
+    if(uni_uLift != -1) glUniform1i(uni_uLift, 1);
+    if(uni_uRotation != -1) glUniformMatrix3fv(uni_uRotation, 1, GL_FALSE, rotation);
+    if(uni_uDisk1 != -1) glUniform2f(uni_uDisk1, (float)(offsetCircle1X - view.centerX), (float)(offsetCircle1Y - view.centerY));
+    if(uni_uDisk2 != -1) glUniform2f(uni_uDisk2, (float)(offsetCircle2X - view.centerX), (float)(offsetCircle2Y - view.centerY));
+    if(uni_uRadius != -1) glUniform1f(uni_uRadius, (float)circleRadius);
+
+    // straight to GL: the lift lives in the shader, and a draw stream records the main view only
+    RenderBackend& gl = glRenderBackend();
+    for(const FrameGeometry* frame : {&scene.background, &scene.geometry}) {
+        gl.drawIndexedRanges(view, frame->ranges.data(), frame->ranges.size(), frame->indices, frame->indexCount,
+                             frame->batches.data(), frame->batches.size());
+    }
+
+    glUseProgram(shaderProgram);
+    if(uni_uLift != -1) glUniform1i(uni_uLift, 0);
+    glUseProgram(0);
+    glFlush();
+    // the viewport belongs to the shared context
+    glViewport(0, 0, currentWindowWidth, currentWindowHeight);
+}
+
+static void reshapeHemisphere(int width, int height) {
+    windowWidth = width;
+    windowHeight = height;
+}
+
+static void mouseHemisphere(int button, int state, int x, int y) {
+    if(button != GLUT_LEFT_BUTTON) return;
+    dragging = state == GLUT_DOWN;
+    dragX = x;
+    dragY = y;
+}
+
+static void dragHemisphere(int x, int y) {
+    if(!dragging) return;
+    yaw += (x - dragX) * 0.01;
+    pitch = std::clamp(pitch + (y - dragY) * 0.01, -M_PI, M_PI);
+    dragX = x;
+    dragY = y;
+    glutPostRedisplay();
+}
+
+static void keyboardHemisphere(unsigned char key, int x, int y) {
+    if(key == 'v' || key == 'V' || key == 27) toggleHemisphereView();
+}
+
+static void closeHemisphere() {
+    hemisphereWindow = 0;
+    hemisphereVisible = false;
+}
+
+// closing the main window still ends the program, as before the second window existed
+static void closeMainWindow() {
+    exit(0);
+}
+
+static void createHemisphereWindow() {
+    mainWindow = glutGetWindow();
+    uni_uLift = glGetUniformLocation(shaderProgram, "uLift");
+    uni_uRotation = glGetUniformLocation(shaderProgram, "uRotation");
+    uni_uDisk1 = glGetUniformLocation(shaderProgram, "uDisk1");
+    uni_uDisk2 = glGetUniformLocation(shaderProgram, "uDisk2");
+    uni_uRadius = glGetUniformLocation(shaderProgram, "uRadius");
+
+    glutSetOption(GLUT_ACTION_ON_WINDOW_CLOSE, GLUT_ACTION_CONTINUE_EXECUTION);
+    glutCloseFunc(closeMainWindow);
+    // one context for both windows: vertex arrays are not shared between contexts
+    glutSetOption(GLUT_RENDERING_CONTEXT, GLUT_USE_CURRENT_CONTEXT);
+    glutInitWindowSize(HEMISPHERE_WINDOW_SIZE, HEMISPHERE_WINDOW_SIZE);
+    hemisphereWindow = glutCreateWindow("Pappus hemisphere - drag to rotate, V to close");
+    glutSetOption(GLUT_RENDERING_CONTEXT, GLUT_CREATE_NEW_CONTEXT);
+    windowWidth = windowHeight = HEMISPHERE_WINDOW_SIZE;
+    glutDisplayFunc(displayHemisphere);
+    glutReshapeFunc(reshapeHemisphere);
+    glutMouseFunc(mouseHemisphere);
+    glutMotionFunc(dragHemisphere);
+    glutKeyboardFunc(keyboardHemisphere);
+    glutCloseFunc(closeHemisphere);
+    glutSetWindow(mainWindow);
+}
+
+void toggleHemisphereView() {
+    if(hemisphereWindow == 0) {
+        createHemisphereWindow();
+        hemisphereVisible = true;
+        return;
+    }
+    int current = glutGetWindow();
+    glutSetWindow(hemisphereWindow);
+    if(hemisphereVisible) glutHideWindow();
+    else glutShowWindow();
+    glutSetWindow(current);
+    hemisphereVisible = !hemisphereVisible;
+    glutPostWindowRedisplay(mainWindow);
+}
+
+void postHemisphereRedisplay() {
+    if(hemisphereWindow != 0 && hemisphereVisible) glutPostWindowRedisplay(hemisphereWindow);
+}
@@ -0,0 +1,335 @@
+#include <GL/glew.h>
+#include <GL/glut.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <tuple>
+#include "iteratedPappus.h"
+#include "TaskPool.h"
+#include "graphics.h"
+#include "utils.h"
+
+int iteratedPappusRounds = ITERATED_PAPPUS_ROUNDS;
+
+static double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// ---- ProjectiveSet ----
+
+uint64_t ProjectiveSet::cellKey(long cx, long cy, long cz) const {
+    // distinct cells may share a key; the chain walk compares the vectors anyway
+    return (uint64_t)cx * 0x9E3779B97F4A7C15ull ^ (uint64_t)cy * 0xC2B2AE3D27D4EB4Full ^ (uint64_t)cz * 0x165667B19E3779F9ull;
+}
+
+long ProjectiveSet::cellOf(double v) const {
+    return (long)std::floor(v / (2 * tolerance));
+}
+
+uint32_t ProjectiveSet::findSigned(const Vector3& unit) const {
+    // with cells of twice the tolerance, at most two per axis can hold a match
+    long lo[3], hi[3];
+    for(int k = 0; k < 3; k++) {
+        lo[k] = cellOf(unit[k] - tolerance);
+        hi[k] = cellOf(unit[k] + tolerance);
+    }
+    for(long cx = lo[0]; cx <= hi[0]; cx++) {
+        for(long cy = lo[1]; cy <= hi[1]; cy++) {
+            for(long cz = lo[2]; cz <= hi[2]; cz++) {
+                auto head = heads.find(cellKey(cx, cy, cz));
+                if(head == heads.end()) continue;
+                for(uint32_t e = head->second; e != NOT_FOUND; e = next[e]) {
+                    Vector3 d = elements[e] - unit;
+                    if(d.dot(d) <= tolerance * tolerance) return e;
+                }
+            }
+        }
+    }
+    return NOT_FOUND;
+}
+
+uint32_t ProjectiveSet::find(const Vector3& unit) const {
+    uint32_t found = findSigned(unit);
+    return found != NOT_FOUND ? found : findSigned(unit * -1.0);
+}
+
+bool ProjectiveSet::insert(const Vector3& unit, uint8_t round) {
+    if(find(unit) != NOT_FOUND) return false;
+    uint32_t index = (uint32_t)elements.size();
+    uint32_t& head = heads.try_emplace(cellKey(cellOf(unit[0]), cellOf(unit[1]), cellOf(unit[2])), NOT_FOUND).first->second;
+    next.push_back(head);
+    head = index;
+    elements.push_back(unit);
+    rounds.push_back(round);
+    return true;
+}
+
+void ProjectiveSet::clear() {
+    heads.clear();
+    next.clear();
+    elements.clear();
+    rounds.clear();
+}
+
+// ---- Iteration ----
+
+// pairs (i, j) with j < i and first <= i < count
+static size_t pairsFrom(size_t first, size_t count) {
+    return count * (count - 1) / 2 - (first == 0 ? 0 : first * (first - 1) / 2);
+}
+
+// cross products of those pairs that are not in `into` yet, merged into it in row order; rows
+// run on the task pool against the set as it was, the merge drops repeats within the round
+static size_t crossPairs(const ProjectiveSet& from, size_t first, ProjectiveSet& into, uint8_t round,
+                         double& generateMs, double& mergeMs) {
+    size_t count = from.size();
+    if(first >= count) return 0;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::vector<Vector3>> rows(count - first);
+    TaskPool::shared().parallelFor(count - first, [&](size_t row) {
+        size_t i = first + row;
+        const Vector3& a = from[i];
+        std::vector<Vector3>& out = rows[row];
+        for(size_t j = 0; j < i; j++) {
+            Vector3 c = a.cross(from[j]);
+            double sine = c.magnitude();
+            if(sine < ITERATED_PAPPUS_MIN_SINE) continue;
+            c = c / sine;
+            if(into.find(c) == ProjectiveSet::NOT_FOUND) out.push_back(c);
+        }
+    });
+    generateMs += elapsedMs(start);
+
+    start = std::chrono::steady_clock::now();
+    size_t added = 0;
+    for(const std::vector<Vector3>& row : rows) {
+        for(const Vector3& c : row) added += into.insert(c, round);
+    }
+    mergeMs += elapsedMs(start);
+    return added;
+}
+
+void iteratePappus(const Vector3 x[3], const Vector3 y[3], int roundCount, IteratedPappus& result, bool verbose) {
+    result.points.clear();
+    result.lines.clear();
+    result.rounds.clear();
+    result.truncated = false;
+    for(int k = 0; k < 3; k++) {
+        result.points.insert(x[k].normalize(), 0);
+        result.points.insert(y[k].normalize(), 0);
+    }
+    if(verbose) printf("iterated Pappus: %zu points, %d rounds on %u threads\n", result.points.size(), roundCount, TaskPool::shared().size());
+
+    size_t firstNewPoint = 0, firstNewLine = 0;
+    for(int r = 1; r <= roundCount; r++) {
+        IteratedRound round;
+        uint8_t tag = (uint8_t)std::min(r, 255);
+        round.linePairs = pairsFrom(firstNewPoint, result.points.size());
+        if(round.linePairs > ITERATED_PAPPUS_MAX_PAIRS) {
+            result.truncated = true;
+            if(verbose) printf("  round %d: %zu joins over the limit of %.0f pairs, stopping\n", r, round.linePairs, ITERATED_PAPPUS_MAX_PAIRS);
+            break;
+        }
+        size_t before = result.lines.size() + result.points.size();
+        round.newLines = crossPairs(result.points, firstNewPoint, result.lines, tag, round.generateMs, round.mergeMs);
+        firstNewPoint = result.points.size();
+
+        round.pointPairs = pairsFrom(firstNewLine, result.lines.size());
+        bool meets = round.pointPairs <= ITERATED_PAPPUS_MAX_PAIRS;
+        if(meets) {
+            round.newPoints = crossPairs(result.lines, firstNewLine, result.points, tag, round.generateMs, round.mergeMs);
+            firstNewLine = result.lines.size();
+        }
+        round.lines = result.lines.size();
+        round.points = result.points.size();
+        result.rounds.push_back(round);
+        if(verbose) {
+            printf("  round %d: %zu lines (+%zu from %zu joins), %zu points (+%zu from %zu meets), growth x%.1f; "
+                   "generate %.2f ms, merge %.2f ms\n",
+                   r, round.lines, round.newLines, round.linePairs, round.points, round.newPoints, meets ? round.pointPairs : 0,
+                   (double)(round.lines + round.points) / before, round.generateMs, round.mergeMs);
+        }
+        if(!meets) {
+            result.truncated = true;
+            if(verbose) printf("  round %d: %zu meets over the limit of %.0f pairs, stopping\n", r, round.pointPairs, ITERATED_PAPPUS_MAX_PAIRS);
+            break;
+        }
+        if(round.newLines == 0 && round.newPoints == 0) break;
+    }
+}
+
+// ---- Drawing ----
+
+// one instance: the unit vector and the round that created it
+struct IteratedInstance {
+    float v[3];
+    float round;
+};
+
+// segments of the upper half of every great circle
+static const int ITERATED_LINE_SEGMENTS = 64;
+// dot radius in pixels
+static const float ITERATED_DOT_RADIUS = 2.0f;
+
+static IteratedPappus iterated;
+static bool showIterated = false;
+static std::tuple<double, double, int, int> iteratedFrom[6];
+static GLuint iteratedProgram = 0, lineVao = 0, pointVao = 0, lineVbo = 0, pointVbo = 0;
+static GLsizei drawnLines = 0, drawnPoints = 0;
+static GLint uni_uIteratedView = -1;
+static GLint uni_uIteratedDisk1 = -1, uni_uIteratedDisk2 = -1;
+static GLint uni_uRadius = -1;
+static GLint uni_uPoints = -1;
+static GLint uni_uIteratedDotSize = -1;
+static GLint uni_uSegments = -1;
+
+// every element twice, on the first disk for even instances and the second for odd ones
+// (attribute divisor 2); dots and half circles are placed from gl_VertexID
+static const char* iteratedVertexShaderSrc = R"glsl(
+#version 330 core
+layout(location = 0) in vec4 inElement; // unit homogeneous vector, round in w
+uniform mat3 uView;
+uniform vec2 uDisk1, uDisk2;            // disk centers relative to the view center
+uniform float uRadius;
+uniform int uPoints;                    // 1: dots at points, 0: lines as strips
+uniform float uDotSize;                 // dot radius in world units
+uniform int uSegments;
+out vec2 corner;
+out vec3 color;
+const vec2 CORNERS[6] = vec2[6](vec2(-1, -1), vec2(1, -1), vec2(1, 1), vec2(-1, -1), vec2(1, 1), vec2(-1, 1));
+const vec3 ROUND_COLORS[4] = vec3[4](vec3(1.0), vec3(1.0, 0.85, 0.2), vec3(1.0, 0.45, 0.1), vec3(0.9, 0.15, 0.5));
+void main() {
+    vec3 e = inElement.z < 0.0 ? -inElement.xyz : inElement.xyz;
+    vec2 disk = (gl_InstanceID & 1) == 1 ? uDisk2 : uDisk1;
+    color = ROUND_COLORS[min(int(inElement.w), 3)];
+    vec2 position;
+    if(uPoints == 1) {
+        corner = CORNERS[gl_VertexID];
+        position = disk + e.xy * uRadius + corner * uDotSize;
+    }
+    else {
+        corner = vec2(0.0);
+        // the GreatCircle basis: u is the point at infinity, v completes the upper half
+        vec3 u = length(e.xy) > 0.0 ? normalize(vec3(-e.y, e.x, 0.0)) : vec3(1.0, 0.0, 0.0);
+        vec3 v = cross(e, u);
+        float t = 3.14159265 * float(gl_VertexID) / float(uSegments);
+        position = disk + (u.xy * cos(t) + v.xy * sin(t)) * uRadius;
+    }
+    gl_Position = vec4((uView * vec3(position, 1.0)).xy, 0.0, 1.0);
+}
+)glsl";
+
+static const char* iteratedFragmentShaderSrc = R"glsl(
+#version 330 core
+in vec2 corner;
+in vec3 color;
+uniform int uPoints;
+out vec4 outColor;
+void main() {
+    // lines stay faint: later rounds pile up thousands of them
+    float alpha = uPoints == 1 ? smoothstep(1.0, 0.7, length(corner)) : 0.3;
+    outColor = vec4(color, alpha);
+}
+)glsl";
+
+static GLuint makeInstanceVao(GLuint vbo) {
+    GLuint vao;
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(IteratedInstance), (void*)0);
+    glVertexAttribDivisor(0, 2);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return vao;
+}
+
+void initIteratedPappusResources() {
+    iteratedProgram = buildProgram(iteratedVertexShaderSrc, iteratedFragmentShaderSrc);
+    uni_uIteratedView = glGetUniformLocation(iteratedProgram, "uView");
+    uni_uIteratedDisk1 = glGetUniformLocation(iteratedProgram, "uDisk1");
+    uni_uIteratedDisk2 = glGetUniformLocation(iteratedProgram, "uDisk2");
+    uni_uRadius = glGetUniformLocation(iteratedProgram, "uRadius");
+    uni_uPoints = glGetUniformLocation(iteratedProgram, "uPoints");
+    uni_uIteratedDotSize = glGetUniformLocation(iteratedProgram, "uDotSize");
+    uni_uSegments = glGetUniformLocation(iteratedProgram, "uSegments");
+    glGenBuffers(1, &lineVbo);
+    glGenBuffers(1, &pointVbo);
+    lineVao = makeInstanceVao(lineVbo);
+    pointVao = makeInstanceVao(pointVbo);
+}
+
+// the first ITERATED_PAPPUS_MAX_DRAWN elements, uploaded once per iteration
+static GLsizei uploadInstances(GLuint vbo, const ProjectiveSet& set) {
+    size_t count = std::min(set.size(), ITERATED_PAPPUS_MAX_DRAWN);
+    std::vector<IteratedInstance> instances(count);
+    for(size_t i = 0; i < count; i++) {
+        instances[i] = {{(float)set[i][0], (float)set[i][1], (float)set[i][2]}, (float)set.roundOf(i)};
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(count * sizeof(IteratedInstance)), instances.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return (GLsizei)count;
+}
+
+static bool markedPointsChanged() {
+    if(collectedPoints < 6) return true;
+    return !std::equal(markedPoints, markedPoints + 6, iteratedFrom);
+}
+
+void toggleIteratedPappus() {
+    if(showIterated) {
+        showIterated = false;
+        glutPostRedisplay();
+        return;
+    }
+    if(collectedPoints < 6) {
+        fprintf(stderr, "iterated Pappus needs the six points of the configuration\n");
+        return;
+    }
+    Vector3 xs[3], ys[3];
+    for(int k = 0; k < 3; k++) {
+        xs[k] = liftToSphere(std::get<0>(markedPoints[k]), std::get<1>(markedPoints[k]), circleRadius);
+        ys[k] = liftToSphere(std::get<0>(markedPoints[3 + k]), std::get<1>(markedPoints[3 + k]), circleRadius);
+    }
+    iteratePappus(xs, ys, iteratedPappusRounds, iterated, true);
+    std::copy(markedPoints, markedPoints + 6, iteratedFrom);
+    drawnLines = uploadInstances(lineVbo, iterated.lines);
+    drawnPoints = uploadInstances(pointVbo, iterated.points);
+    if((size_t)drawnLines < iterated.lines.size() || (size_t)drawnPoints < iterated.points.size()) {
+        printf("  drawing the first %d lines and %d points\n", drawnLines, drawnPoints);
+    }
+    showIterated = true;
+    glutPostRedisplay();
+}
+
+void drawIteratedPappus(const ViewTransform& view) {
+    if(!showIterated) return;
+    if(markedPointsChanged()) {
+        showIterated = false;
+        return;
+    }
+    glUseProgram(iteratedProgram);
+    if(uni_uIteratedView != -1) {
+        float m[9];
+        view.relativeMatrix(m);
+        glUniformMatrix3fv(uni_uIteratedView, 1, GL_FALSE, m);
+    }
+    if(uni_uIteratedDisk1 != -1) glUniform2f(uni_uIteratedDisk1, (float)(offsetCircle1X - view.centerX), (float)(offsetCircle1Y - view.centerY));
+    if(uni_uIteratedDisk2 != -1) glUniform2f(uni_uIteratedDisk2, (float)(offsetCircle2X - view.centerX), (float)(offsetCircle2Y - view.centerY));
+    if(uni_uRadius != -1) glUniform1f(uni_uRadius, (float)circleRadius);
+    if(uni_uIteratedDotSize != -1) glUniform1f(uni_uIteratedDotSize, (float)(ITERATED_DOT_RADIUS * view.pixelSize));
+    if(uni_uSegments != -1) glUniform1i(uni_uSegments, ITERATED_LINE_SEGMENTS);
+
+    if(uni_uPoints != -1) glUniform1i(uni_uPoints, 0);
+    glBindVertexArray(lineVao);
+    glDrawArraysInstanced(GL_LINE_STRIP, 0, ITERATED_LINE_SEGMENTS + 1, 2 * drawnLines);
+    if(uni_uPoints != -1) glUniform1i(uni_uPoints, 1);
+    glBindVertexArray(pointVao);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 6, 2 * drawnPoints);
+    renderStats.drawCalls += 2;
+    glBindVertexArray(0);
+    glUseProgram(0);
+}
@@ -2,8 +2,42 @@
 #include <GL/glut.h>
 #include "graphics.h"
 #include "utils.h"
+#include "pipeline.h"
+#include "gallery.h"
+#include "quality.h"
+#include "antialiasing.h"
+#include "capture.h"
+#include "correspondenceMap.h"
+#include "programCache.h"
+#include "startupTiming.h"
+#include "computeServer.h"
+#include "cpuRasterizer.h"
+#include "iteratedPappus.h"
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
 
 int main(int argc,char** argv) {
+    // headless batch modes, also built without GL (tools/pappusHeadless.cpp)
+    int headlessStatus = runHeadlessCommand(argc, argv);
+    if(headlessStatus >= 0) return headlessStatus;
+
+    // --capture-offscreen <path> [width height]: the window only provides the context
+    const char* offscreenCapturePath = nullptr;
+    int offscreenWidth = INITIAL_WINDOW_WIDTH, offscreenHeight = INITIAL_WINDOW_HEIGHT;
+    if(argc > 2 && strcmp(argv[1], "--capture-offscreen") == 0) {
+        offscreenCapturePath = argv[2];
+        if(argc > 4) {
+            offscreenWidth = atoi(argv[3]);
+            offscreenHeight = atoi(argv[4]);
+        }
+        if(offscreenWidth < 1 || offscreenHeight < 1) {
+            fprintf(stderr, "Capture size must be positive\n");
+            return 1;
+        }
+    }
+
+    startStartupTiming();
     glutInit(&argc,argv);
     // Note: removed glutInitContextVersion/glutInitContextProfile for compatibility
 
@@ -11,6 +45,8 @@ int main(int argc,char** argv) {
     glutInitWindowSize(INITIAL_WINDOW_WIDTH, INITIAL_WINDOW_HEIGHT);
     glutInitWindowPosition(0,0);
     glutCreateWindow("Pappus Construction - Press F for fullscreen, Q to quit");
+    if(offscreenCapturePath) glutHideWindow();
+    markStartupPhase("window");
 
     // Initialize GLEW after creating an OpenGL context
     glewExperimental = GL_TRUE;
@@ -19,14 +55,80 @@ int main(int argc,char** argv) {
         fprintf(stderr, "Error initializing GLEW: %s\n", glewGetErrorString(err));
         return 1;
     }
+    markStartupPhase("glew");
+
+    // --gallery [points file] starts in gallery mode, --gallery-sweep benchmarks it,
+    // --quality-levels and --frame-budget configure progressive refinement,
+    // --no-shader-cache compiles every program as on a cold start,
+    // --aa smooth|msaa|fxaa|none selects the anti-aliasing mode,
+    // --capture <path> records from the first frame,
+    // --map-bench N times the batch correspondence map on CPU and GPU and exits,
+    // --raster-bench N does the same for the GL driver and the CPU rasterizer,
+    // --iterate-rounds K sets the rounds of the iterated construction (key I)
+    const char* capturePath = nullptr;
+    size_t mapBenchCount = 0, rasterBenchCount = 0;
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "--gallery") == 0) {
+            galleryMode = true;
+            if(i + 1 < argc && argv[i + 1][0] != '-') loadGalleryPoints(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--no-shader-cache") == 0) {
+            useProgramCache = false;
+        }
+        else if(strcmp(argv[i], "--gallery-sweep") == 0) {
+            startGallerySweep();
+        }
+        else if(strcmp(argv[i], "--capture") == 0 && i + 1 < argc) {
+            capturePath = argv[++i];
+        }
+        else if(strcmp(argv[i], "--map-bench") == 0 && i + 1 < argc) {
+            mapBenchCount = strtoull(argv[++i], nullptr, 10);
+        }
+        else if(strcmp(argv[i], "--raster-bench") == 0 && i + 1 < argc) {
+            rasterBenchCount = strtoull(argv[++i], nullptr, 10);
+        }
+        else if(strcmp(argv[i], "--iterate-rounds") == 0 && i + 1 < argc) {
+            iteratedPappusRounds = std::max(1, atoi(argv[++i]));
+        }
+        else if(strcmp(argv[i], "--aa") == 0 && i + 1 < argc) {
+            if(!parseAntialiasingMode(argv[++i])) fprintf(stderr, "Ignoring unknown --aa mode %s\n", argv[i]);
+        }
+        else if(i + 1 < argc && parseQualityOption(argv[i], argv[i + 1])) {
+            i++;
+        }
+        else if(strcmp(argv[i], "--quality-levels") == 0 || strcmp(argv[i], "--frame-budget") == 0) {
+            fprintf(stderr, "Ignoring invalid %s value\n", argv[i]);
+            if(i + 1 < argc) i++;
+        }
+    }
 
     myInit();
     initGLResources();
+    markStartupPhase("GL resources");
+    if(offscreenCapturePath) {
+        return runOffscreenCapture(stdin, offscreenCapturePath, offscreenWidth, offscreenHeight);
+    }
+    if(mapBenchCount > 0) {
+        runCorrespondenceBenchmark(mapBenchCount);
+        return 0;
+    }
+    if(rasterBenchCount > 0) {
+        runRasterBenchmark(rasterBenchCount);
+        return 0;
+    }
+    if(capturePath) startCapture(capturePath);
     glutMouseFunc(mouseClickCallback);
     glutPassiveMotionFunc(passiveMouseMotion);
+    glutMotionFunc(mouseDragCallback);
     glutDisplayFunc(display);
     glutReshapeFunc(reshapeCallback);
     glutKeyboardFunc(keyboardCallback);
+    glutSpecialFunc(specialKeyCallback);
+
+    // geometry is built off the GLUT thread, kick off the first scene
+    startScenePipeline();
+    publishInput();
+    markStartupPhase("pipeline");
     glutMainLoop();
 }
 
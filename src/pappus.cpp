@@ -0,0 +1,229 @@
+#include "pappus.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include "utils.h"
+#include "Matrix3.h"
+#include "TaskPool.h"
+
+PappusConfiguration computePappus(const Vector3 x[3], const Vector3 y[3]) {
+    PappusConfiguration config;
+    for(int i = 0; i < 3; i++) {
+        config.x[i] = x[i];
+        config.y[i] = y[i];
+    }
+
+    // all lines between points (necessary for pappus line)
+    Vector3 x1y2 = x[0].cross(y[1]);
+    Vector3 x2y1 = x[1].cross(y[0]);
+    Vector3 x1y3 = x[0].cross(y[2]);
+    Vector3 x3y1 = x[2].cross(y[0]);
+    Vector3 x2y3 = x[1].cross(y[2]);
+    Vector3 y2x3 = y[1].cross(x[2]);
+
+    config.intersections[0] = lineIntersection(x1y2, x2y1);
+    config.intersections[1] = lineIntersection(x1y3, x3y1);
+    config.intersections[2] = lineIntersection(x2y3, y2x3);
+
+    config.chosen1 = config.intersections[0];
+    config.chosen2 = config.intersections[1];
+    if(!checkLinePointsDifferent(config.intersections[0], config.intersections[1])) {
+        config.chosen2 = config.intersections[2];
+    }
+    config.axis = config.chosen1.cross(config.chosen2);
+    return config;
+}
+
+double pappusResidual(const PappusConfiguration& config) {
+    Vector3 axis = config.axis.normalize();
+    double residual = 0;
+    for(const Vector3& intersection : config.intersections) {
+        residual = std::max(residual, std::abs(axis.dot(intersection.normalize())));
+    }
+    return residual;
+}
+
+PappusImage pappusImage(const PappusConfiguration& config, const Vector3& point) {
+    PappusImage result;
+    const Vector3 &x1 = config.x[0], &x2 = config.x[1];
+    const Vector3 &y1 = config.y[0], &y2 = config.y[1], &y3 = config.y[2];
+    result.center1 = y1;
+    result.center2 = x1;
+    if(checkInfinityPoint(y1[0], y1[1]) && checkInfinityPoint(x1[0], x1[1])) {
+        result.center1 = y2;
+        result.center2 = x2;
+    }
+
+    Vector3 imageLine = y2.cross(y3);
+    Vector3 firstCorrespondenceLine = result.center1.cross(point);
+    result.axisPoint = lineIntersection(config.axis, firstCorrespondenceLine);
+    Vector3 secondCorrespondenceLine = result.center2.cross(result.axisPoint);
+    result.image = lineIntersection(imageLine, secondCorrespondenceLine);
+
+    if(result.image[2] < 0) result.image = result.image * -1;
+    if(result.axisPoint[2] < 0) result.axisPoint = result.axisPoint * -1;
+    return result;
+}
+
+// ---- Least-squares axis ----
+
+// two doubles per operation, the width every x86-64 (SSE2) and ARMv8 (NEON) target has;
+// GCC/Clang vector extension
+typedef double Lanes __attribute__((vector_size(2 * sizeof(double))));
+const size_t LANE_COUNT = 2;
+
+static inline Lanes loadLanes(const double* p) {
+    Lanes v;
+    memcpy(&v, p, sizeof v);
+    return v;
+}
+
+static inline Lanes broadcast(double v) {
+    return Lanes{v, v};
+}
+
+static inline double sumLanes(Lanes v) {
+    return v[0] + v[1];
+}
+
+// a join with sin^2 of the angle between its lines below this is left out of the max residual
+const double WELL_CONDITIONED_SIN2 = 1e-6;
+
+// unit vectors split into coordinate arrays, zero padded so a row can always read whole lanes
+struct PointColumns {
+    double* x[3];
+    double* y[3];
+};
+
+// cross-joins of row i against every j > i: P = (x_i y_j) x (x_j y_i) and s2 = |x_i y_j|^2 |x_j y_i|^2
+template<typename Visit>
+static void forEachJoin(const PointColumns& c, size_t i, size_t n, Visit visit) {
+    Lanes xi0 = broadcast(c.x[0][i]), xi1 = broadcast(c.x[1][i]), xi2 = broadcast(c.x[2][i]);
+    Lanes yi0 = broadcast(c.y[0][i]), yi1 = broadcast(c.y[1][i]), yi2 = broadcast(c.y[2][i]);
+    for(size_t j = i + 1; j < n; j += LANE_COUNT) {
+        Lanes xj0 = loadLanes(c.x[0] + j), xj1 = loadLanes(c.x[1] + j), xj2 = loadLanes(c.x[2] + j);
+        Lanes yj0 = loadLanes(c.y[0] + j), yj1 = loadLanes(c.y[1] + j), yj2 = loadLanes(c.y[2] + j);
+        Lanes a0 = xi1 * yj2 - xi2 * yj1, a1 = xi2 * yj0 - xi0 * yj2, a2 = xi0 * yj1 - xi1 * yj0;
+        Lanes b0 = xj1 * yi2 - xj2 * yi1, b1 = xj2 * yi0 - xj0 * yi2, b2 = xj0 * yi1 - xj1 * yi0;
+        Lanes p0 = a1 * b2 - a2 * b1, p1 = a2 * b0 - a0 * b2, p2 = a0 * b1 - a1 * b0;
+        Lanes s2 = (a0 * a0 + a1 * a1 + a2 * a2) * (b0 * b0 + b1 * b1 + b2 * b2);
+        // lanes past n read the zero padding and come out as P = 0
+        visit(p0, p1, p2, s2);
+    }
+}
+
+// eigenvector of the smallest eigenvalue of a symmetric matrix, by cyclic Jacobi rotations
+static Vector3 smallestEigenvector(Matrix3 a) {
+    Matrix3 v = Matrix3::identity();
+    for(int sweep = 0; sweep < 32; sweep++) {
+        double off = a(0, 1) * a(0, 1) + a(0, 2) * a(0, 2) + a(1, 2) * a(1, 2);
+        if(off < 1e-30) break;
+        for(int p = 0; p < 2; p++) {
+            for(int q = p + 1; q < 3; q++) {
+                if(a(p, q) == 0) continue;
+                double theta = (a(q, q) - a(p, p)) / (2 * a(p, q));
+                double t = (theta >= 0 ? 1 : -1) / (std::abs(theta) + std::sqrt(theta * theta + 1));
+                double c = 1 / std::sqrt(t * t + 1), s = t * c;
+                for(int k = 0; k < 3; k++) {
+                    double akp = a(k, p), akq = a(k, q);
+                    a(k, p) = c * akp - s * akq;
+                    a(k, q) = s * akp + c * akq;
+                }
+                for(int k = 0; k < 3; k++) {
+                    double apk = a(p, k), aqk = a(q, k);
+                    a(p, k) = c * apk - s * aqk;
+                    a(q, k) = s * apk + c * aqk;
+                }
+                for(int k = 0; k < 3; k++) {
+                    double vkp = v(k, p), vkq = v(k, q);
+                    v(k, p) = c * vkp - s * vkq;
+                    v(k, q) = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+    int smallest = 0;
+    for(int k = 1; k < 3; k++) if(a(k, k) < a(smallest, smallest)) smallest = k;
+    return Vector3(v(0, smallest), v(1, smallest), v(2, smallest));
+}
+
+AxisFit fitPappusAxis(const Vector3* x, const Vector3* y, size_t n) {
+    auto start = std::chrono::steady_clock::now();
+    AxisFit fit;
+    fit.pointsPerLine = n;
+    fit.intersectionCount = n < 2 ? 0 : n * (n - 1) / 2;
+    if(n < 2) return fit;
+
+    // reused between fits: steady-state rebuilds do not touch the heap
+    static thread_local std::vector<double> columns, rowSums;
+    size_t stride = n + LANE_COUNT;
+    columns.assign(6 * stride, 0.0);
+    PointColumns c;
+    for(int k = 0; k < 3; k++) {
+        c.x[k] = columns.data() + k * stride;
+        c.y[k] = columns.data() + (3 + k) * stride;
+    }
+    for(size_t i = 0; i < n; i++) {
+        Vector3 xu = x[i].normalize(), yu = y[i].normalize();
+        for(int k = 0; k < 3; k++) {
+            c.x[k][i] = xu[k];
+            c.y[k][i] = yu[k];
+        }
+    }
+
+    // pass 1: M = sum of P P^T / s2, i.e. unit intersections weighted by sin^2; one row per job
+    const int SUMS = 6;
+    rowSums.assign(n * SUMS, 0.0);
+    TaskPool::shared().parallelFor(n, [&](size_t i) {
+        Lanes m00 = {}, m01 = {}, m02 = {}, m11 = {}, m12 = {}, m22 = {};
+        forEachJoin(c, i, n, [&](Lanes p0, Lanes p1, Lanes p2, Lanes s2) {
+            Lanes w = 1.0 / (s2 + 1e-300);
+            m00 += p0 * p0 * w; m01 += p0 * p1 * w; m02 += p0 * p2 * w;
+            m11 += p1 * p1 * w; m12 += p1 * p2 * w; m22 += p2 * p2 * w;
+        });
+        double* out = &rowSums[i * SUMS];
+        out[0] = sumLanes(m00); out[1] = sumLanes(m01); out[2] = sumLanes(m02);
+        out[3] = sumLanes(m11); out[4] = sumLanes(m12); out[5] = sumLanes(m22);
+    });
+    double m[SUMS] = {};
+    for(size_t i = 0; i < n; i++) {
+        for(int k = 0; k < SUMS; k++) m[k] += rowSums[i * SUMS + k];
+    }
+    Matrix3 scatter(m[0], m[1], m[2],
+                    m[1], m[3], m[4],
+                    m[2], m[4], m[5]);
+    Vector3 axis = smallestEigenvector(scatter).normalize();
+    if(axis[2] < 0) axis = axis * -1;
+    fit.axis = axis;
+    double totalWeight = m[0] + m[3] + m[5];
+
+    // pass 2: residuals against the fitted axis, weighted as in the fit (the smallest eigenvalue
+    // is the same sum, but its rounding would dominate a near-exact fit) and the worst among
+    // joins that are not near-degenerate
+    Lanes n0 = broadcast(axis[0]), n1 = broadcast(axis[1]), n2 = broadcast(axis[2]);
+    TaskPool::shared().parallelFor(n, [&](size_t i) {
+        Lanes squares = {}, worst = {};
+        forEachJoin(c, i, n, [&](Lanes p0, Lanes p1, Lanes p2, Lanes s2) {
+            Lanes d = n0 * p0 + n1 * p1 + n2 * p2;
+            Lanes p2sum = p0 * p0 + p1 * p1 + p2 * p2;
+            squares += d * d / (s2 + 1e-300);
+            Lanes ratio = d * d / (p2sum + 1e-300);
+            ratio = p2sum > WELL_CONDITIONED_SIN2 * s2 ? ratio : Lanes{};
+            worst = worst > ratio ? worst : ratio;
+        });
+        rowSums[i * SUMS] = sumLanes(squares);
+        rowSums[i * SUMS + 1] = std::max(worst[0], worst[1]);
+    });
+    double squares = 0, worst = 0;
+    for(size_t i = 0; i < n; i++) {
+        squares += rowSums[i * SUMS];
+        worst = std::max(worst, rowSums[i * SUMS + 1]);
+    }
+    fit.rmsResidual = totalWeight > 0 ? std::sqrt(squares / totalWeight) : 0.0;
+    fit.maxResidual = std::sqrt(worst);
+
+    fit.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return fit;
+}
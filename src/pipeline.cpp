@@ -0,0 +1,147 @@
+#include <GL/glew.h>
+#include <GL/glut.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include "pipeline.h"
+#include "graphics.h"
+#include "utils.h"
+#include "conics.h"
+#include "TripleBuffer.h"
+#include "allocationCounter.h"
+#include "quality.h"
+
+// input -> compute and compute -> render exchanges, both lock-free
+static TripleBuffer<InputState> inputBuffer;
+static TripleBuffer<SceneSnapshot> sceneBuffer;
+
+static std::thread computeThread;
+// only used to let the compute stage sleep while there is no new input
+static std::mutex wakeMutex;
+static std::condition_variable wakeCompute;
+static std::atomic<bool> stopping{false};
+static std::atomic<uint64_t> publishedInput{0};
+static std::atomic<uint64_t> builtInput{0};
+
+static uint64_t inputSequence = 0; // GLUT thread only
+static bool idleArmed = false;
+
+static void computeLoop() {
+    uint64_t seen = 0;
+    for(;;) {
+        {
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            wakeCompute.wait(lock, [&]{ return stopping.load() || publishedInput.load() != seen; });
+        }
+        if(stopping) return;
+        if(!inputBuffer.update()) {
+            seen = publishedInput.load();
+            continue;
+        }
+        const InputState& input = inputBuffer.front();
+        seen = input.sequence;
+
+        // frame N+1 is built here while the render stage may still be submitting frame N
+        SceneSnapshot& snapshot = sceneBuffer.back();
+        uint64_t allocationsBefore = heapAllocationCount();
+        auto buildStart = std::chrono::steady_clock::now();
+        uint64_t backgroundKey = backgroundLayerKey(input);
+        if(snapshot.backgroundKey != backgroundKey) {
+            buildBackgroundLayer(input, snapshot.background);
+            snapshot.hasAxis = drawnPappusAxis(input, snapshot.axis);
+            snapshot.backgroundKey = backgroundKey;
+        }
+        buildForegroundLayer(input, snapshot.geometry);
+        snapshot.labelCount = buildSceneLabels(input, snapshot.labels);
+        snapshot.hasCorrespondence = interactiveCorrespondence(input, snapshot.correspondence);
+        snapshot.buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart).count();
+        snapshot.buildAllocations = heapAllocationCount() - allocationsBefore;
+        snapshot.inputSequence = input.sequence;
+        snapshot.qualityLevel = input.qualityLevel;
+        sceneBuffer.publish();
+        builtInput.store(input.sequence);
+    }
+}
+
+static void stopScenePipeline() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopping = true;
+    }
+    wakeCompute.notify_one();
+    if(computeThread.joinable()) computeThread.join();
+}
+
+// polls for finished scenes while a build is in flight, drives quality refinement once
+// the pipeline is drained, then unregisters itself
+static void pipelineIdle() {
+    uint64_t built = builtInput.load();
+    if(sceneBuffer.hasUpdate()) {
+        glutPostRedisplay();
+        return;
+    }
+    if(built == publishedInput.load() && !refineQualityWhenIdle()) {
+        glutIdleFunc(nullptr);
+        idleArmed = false;
+        return;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+void startScenePipeline() {
+    // the pool must outlive the compute stage, so create it before registering the exit hook
+    TaskPool::shared();
+    computeThread = std::thread(computeLoop);
+    atexit(stopScenePipeline);
+}
+
+void publishInput() {
+    InputState& input = inputBuffer.back();
+    for(int i = 0; i < 6; i++) input.markedPoints[i] = markedPoints[i];
+    input.collectedPoints = collectedPoints;
+    input.drawablePoints = drawablePoints;
+    input.interactivePoint = interactivePoint;
+    input.canDrawInteractivePoint = canDrawInteractivePoint;
+    for(int line = 0; line < 2; line++) {
+        std::copy(extraPoints[line], extraPoints[line] + extraPointCount[line], input.extraPoints[line]);
+        input.extraPointCount[line] = extraPointCount[line];
+    }
+    input.extraPointsVersion = extraPointsVersion;
+    input.extraCandidate = extraCandidate;
+    input.extraCandidateLine = extraPointMode ? extraCandidateLine : -1;
+    input.showSupportingLines = showSupportingLines;
+    input.analyticConics = useAnalyticConics;
+    input.camera = camera;
+    input.viewWidth = currentWindowWidth;
+    input.viewHeight = currentWindowHeight;
+    fillQuality(input);
+    input.sequence = ++inputSequence;
+    inputBuffer.publish();
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        publishedInput.store(inputSequence);
+    }
+    wakeCompute.notify_one();
+
+    if(!idleArmed) {
+        glutIdleFunc(pipelineIdle);
+        idleArmed = true;
+    }
+}
+
+uint64_t latestInputSequence() {
+    return inputSequence;
+}
+
+const SceneSnapshot& acquireLatestScene() {
+    sceneBuffer.update();
+    return sceneBuffer.front();
+}
+
+const SceneSnapshot& currentScene() {
+    return sceneBuffer.front();
+}
@@ -0,0 +1,84 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+#include "pngWriter.h"
+
+static uint32_t crcTable[256];
+
+static bool initCrcTable() {
+    for(uint32_t n = 0; n < 256; n++) {
+        uint32_t c = n;
+        for(int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        crcTable[n] = c;
+    }
+    return true;
+}
+
+static uint32_t updateCrc(uint32_t crc, const unsigned char* data, size_t bytes) {
+    for(size_t i = 0; i < bytes; i++) crc = crcTable[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return crc;
+}
+
+static void putBigEndian(std::vector<unsigned char>& out, uint32_t value) {
+    out.push_back(value >> 24); out.push_back(value >> 16); out.push_back(value >> 8); out.push_back(value);
+}
+
+static void writeChunk(FILE* f, const char* type, const std::vector<unsigned char>& data) {
+    std::vector<unsigned char> header;
+    putBigEndian(header, (uint32_t)data.size());
+    header.insert(header.end(), type, type + 4);
+    uint32_t crc = updateCrc(0xFFFFFFFFu, header.data() + 4, 4);
+    crc = updateCrc(crc, data.data(), data.size()) ^ 0xFFFFFFFFu;
+    std::vector<unsigned char> trailer;
+    putBigEndian(trailer, crc);
+    fwrite(header.data(), 1, header.size(), f);
+    fwrite(data.data(), 1, data.size(), f);
+    fwrite(trailer.data(), 1, trailer.size(), f);
+}
+
+bool writePng(const char* path, const unsigned char* rgba, int width, int height) {
+    // also used outside of a capture, so the table is filled on first use
+    static const bool crcReady = initCrcTable();
+    (void)crcReady;
+    FILE* f = fopen(path, "wb");
+    if(!f) return false;
+    static const unsigned char signature[8] = {137, 'P', 'N', 'G', 13, 10, 26, 10};
+    fwrite(signature, 1, 8, f);
+
+    std::vector<unsigned char> ihdr;
+    putBigEndian(ihdr, width);
+    putBigEndian(ihdr, height);
+    ihdr.insert(ihdr.end(), {8, 2, 0, 0, 0}); // 8-bit RGB
+    writeChunk(f, "IHDR", ihdr);
+
+    // filter byte 0 per row, rows flipped to top first
+    std::vector<unsigned char> raw;
+    raw.reserve((size_t)height * (width * 3 + 1));
+    for(int y = height - 1; y >= 0; y--) {
+        raw.push_back(0);
+        const unsigned char* row = rgba + (size_t)y * width * 4;
+        for(int x = 0; x < width; x++) raw.insert(raw.end(), row + x * 4, row + x * 4 + 3);
+    }
+
+    std::vector<unsigned char> idat = {0x78, 0x01};
+    uint32_t adlerA = 1, adlerB = 0;
+    for(size_t pos = 0; pos < raw.size() || pos == 0; ) {
+        size_t length = std::min<size_t>(65535, raw.size() - pos);
+        bool last = pos + length == raw.size();
+        idat.push_back(last ? 1 : 0);
+        idat.push_back(length & 0xFF); idat.push_back(length >> 8);
+        idat.push_back(~length & 0xFF); idat.push_back((~length >> 8) & 0xFF);
+        idat.insert(idat.end(), raw.begin() + pos, raw.begin() + pos + length);
+        for(size_t i = pos; i < pos + length; i++) {
+            adlerA = (adlerA + raw[i]) % 65521;
+            adlerB = (adlerB + adlerA) % 65521;
+        }
+        pos += length;
+        if(last) break;
+    }
+    putBigEndian(idat, (adlerB << 16) | adlerA);
+    writeChunk(f, "IDAT", idat);
+    writeChunk(f, "IEND", {});
+    return fclose(f) == 0;
+}
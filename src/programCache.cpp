@@ -0,0 +1,131 @@
+#include <GL/glew.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include "programCache.h"
+
+bool useProgramCache = true;
+int programCacheHits = 0;
+int programCacheMisses = 0;
+
+static const uint32_t CACHE_MAGIC = 0x50505243; // "CRPP"
+static const uint32_t CACHE_VERSION = 1;
+
+struct CacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t binaryFormat;
+    uint32_t length;
+};
+
+static uint64_t fnv1a(uint64_t hash, const char* text) {
+    for(; *text; text++) {
+        hash ^= (unsigned char)*text;
+        hash *= 1099511628211ull;
+    }
+    // separator so ("ab", "c") and ("a", "bc") differ
+    hash ^= 0xff;
+    hash *= 1099511628211ull;
+    return hash;
+}
+
+// the binary is only valid for the exact driver that produced it
+static uint64_t cacheKey(const char* vsSrc, const char* fsSrc) {
+    uint64_t hash = 14695981039346656037ull;
+    GLenum strings[3] = {GL_VENDOR, GL_RENDERER, GL_VERSION};
+    for(GLenum name : strings) {
+        const char* value = (const char*)glGetString(name);
+        hash = fnv1a(hash, value ? value : "");
+    }
+    hash = fnv1a(hash, vsSrc);
+    return fnv1a(hash, fsSrc);
+}
+
+// $XDG_CACHE_HOME/pappus or ~/.cache/pappus, created on demand; empty if neither is set
+static std::string cacheDirectory() {
+    std::string base;
+    if(const char* xdg = getenv("XDG_CACHE_HOME")) base = xdg;
+    else if(const char* home = getenv("HOME")) base = std::string(home) + "/.cache";
+    else return "";
+    mkdir(base.c_str(), 0755);
+    std::string dir = base + "/pappus";
+    mkdir(dir.c_str(), 0755);
+    return dir;
+}
+
+static std::string cachePath(uint64_t key) {
+    std::string dir = cacheDirectory();
+    if(dir.empty()) return "";
+    char name[32];
+    snprintf(name, sizeof(name), "/%016llx.bin", (unsigned long long)key);
+    return dir + name;
+}
+
+bool programBinarySupported() {
+    if(!(GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary)) return false;
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return formats > 0;
+}
+
+GLuint loadCachedProgram(const char* vsSrc, const char* fsSrc) {
+    if(!useProgramCache || !programBinarySupported()) return 0;
+    uint64_t key = cacheKey(vsSrc, fsSrc);
+    std::string path = cachePath(key);
+    if(path.empty()) return 0;
+    FILE* file = fopen(path.c_str(), "rb");
+    if(!file) return 0;
+
+    CacheHeader header;
+    std::vector<char> binary;
+    bool valid = fread(&header, sizeof(header), 1, file) == 1 &&
+                 header.magic == CACHE_MAGIC && header.version == CACHE_VERSION && header.key == key;
+    if(valid) {
+        binary.resize(header.length);
+        valid = fread(binary.data(), 1, binary.size(), file) == binary.size();
+    }
+    fclose(file);
+    if(!valid) return 0;
+
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, header.binaryFormat, binary.data(), (GLsizei)binary.size());
+    GLint ok = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &ok);
+    if(!ok) {
+        // driver update or rejected binary: drop it so the next store replaces it
+        glDeleteProgram(program);
+        remove(path.c_str());
+        return 0;
+    }
+    programCacheHits++;
+    return program;
+}
+
+void storeCachedProgram(GLuint program, const char* vsSrc, const char* fsSrc) {
+    programCacheMisses++;
+    if(!useProgramCache || !programBinarySupported()) return;
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if(length <= 0) return;
+    std::vector<char> binary(length);
+    GLenum binaryFormat = 0;
+    glGetProgramBinary(program, length, &length, &binaryFormat, binary.data());
+
+    uint64_t key = cacheKey(vsSrc, fsSrc);
+    std::string path = cachePath(key);
+    if(path.empty()) return;
+    // write to a temporary name first so a crash never leaves a truncated entry behind
+    std::string temporary = path + ".tmp";
+    FILE* file = fopen(temporary.c_str(), "wb");
+    if(!file) return;
+    CacheHeader header = {CACHE_MAGIC, CACHE_VERSION, key, binaryFormat, (uint32_t)length};
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   fwrite(binary.data(), 1, (size_t)length, file) == (size_t)length;
+    fclose(file);
+    if(written) rename(temporary.c_str(), path.c_str());
+    else remove(temporary.c_str());
+}
@@ -0,0 +1,93 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include "quality.h"
+
+QualitySettings qualitySettings;
+bool progressiveQuality = true;
+
+static std::vector<double> measuredMs; // moving average per level, negative until measured
+static int currentLevel = -1;          // -1: finest
+static bool extrasShown = true;
+static bool refining = false;
+static std::chrono::steady_clock::time_point lastMotion;
+
+static int finestLevel() {
+    return (int)qualitySettings.levels.size() - 1;
+}
+
+bool parseQualityOption(const char* option, const char* value) {
+    if(strcmp(option, "--frame-budget") == 0) {
+        double budget = atof(value);
+        if(budget <= 0) return false;
+        qualitySettings.frameBudgetMs = budget;
+        return true;
+    }
+    if(strcmp(option, "--quality-levels") == 0) {
+        std::vector<double> levels;
+        const char* cursor = value;
+        while(*cursor) {
+            char* end;
+            double step = strtod(cursor, &end);
+            if(end == cursor || step <= 0) return false;
+            if(*end != ',' && *end != '\0') return false;
+            levels.push_back(step);
+            cursor = *end == ',' ? end + 1 : end;
+        }
+        if(levels.empty()) return false;
+        qualitySettings.levels = levels;
+        return true;
+    }
+    return false;
+}
+
+// finest level whose measured cost fits the budget; the coarsest one is always allowed
+static int motionLevel() {
+    measuredMs.resize(qualitySettings.levels.size(), -1.0);
+    int level = 0;
+    for(int i = 1; i <= finestLevel(); i++) {
+        if(measuredMs[i] >= 0 && measuredMs[i] <= qualitySettings.frameBudgetMs) level = i;
+    }
+    return level;
+}
+
+void noteMotion() {
+    if(!progressiveQuality) return;
+    lastMotion = std::chrono::steady_clock::now();
+    currentLevel = motionLevel();
+    extrasShown = false;
+    refining = true;
+}
+
+void fillQuality(InputState& input) {
+    int level = (!progressiveQuality || currentLevel < 0) ? finestLevel() : currentLevel;
+    input.qualityLevel = level;
+    input.tessellationStep = qualitySettings.levels[level];
+    input.drawExtras = !progressiveQuality || extrasShown;
+}
+
+bool refineQualityWhenIdle() {
+    if(!refining) return false;
+    if(!progressiveQuality) {
+        refining = false;
+        return false;
+    }
+    double sinceMotion = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - lastMotion).count();
+    if(sinceMotion < qualitySettings.settleMs) return true;
+
+    // one level per frame, extras come back with the first refinement
+    if(currentLevel >= finestLevel() && extrasShown) {
+        refining = false;
+        return false;
+    }
+    extrasShown = true;
+    if(currentLevel < finestLevel()) currentLevel++;
+    publishInput();
+    return true;
+}
+
+void recordFrameTime(int level, double ms) {
+    measuredMs.resize(qualitySettings.levels.size(), -1.0);
+    if(level < 0 || level > finestLevel()) return;
+    measuredMs[level] = measuredMs[level] < 0 ? ms : measuredMs[level] * 0.8 + ms * 0.2;
+}
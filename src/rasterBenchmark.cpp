@@ -0,0 +1,82 @@
+#include <GL/glew.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+#include "cpuRasterizer.h"
+#include "scene.h"
+#include "utils.h"
+
+// --raster-bench: the GL driver against the CPU rasterizer on the same scene. Kept apart from
+// cpuRasterizer.cpp, which has to link without GL
+
+static double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void runRasterBenchmark(size_t frames) {
+    int width = currentWindowWidth, height = currentWindowHeight;
+    // the configuration of the correspondence benchmark, with an interactive point
+    const double values[14] = {50, 30, -80, 60, 10, 20, 40, -70, -20, 90, 0, 0, 120, -40};
+    static FrameGeometry background, foreground;
+    buildRecordScene(values, 14, width, height, background, foreground);
+    size_t vertexCount = background.vertexCount() + foreground.vertexCount();
+
+    // GL: an offscreen target of the same size, smooth lines as in the default mode
+    GLuint fbo, colorBuffer;
+    glGenFramebuffers(1, &fbo);
+    glGenRenderbuffers(1, &colorBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+    glViewport(0, 0, width, height);
+    glEnable(GL_LINE_SMOOTH);
+    auto drawGl = [&]() {
+        glClear(GL_COLOR_BUFFER_BIT);
+        background.submit();
+        foreground.submit();
+    };
+    drawGl();
+    glFinish();
+    auto start = std::chrono::steady_clock::now();
+    for(size_t i = 0; i < frames; i++) drawGl();
+    glFinish();
+    double glMs = elapsedMs(start) / frames;
+    std::vector<unsigned char> glPixels((size_t)width * height * 4);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, glPixels.data());
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteRenderbuffers(1, &colorBuffer);
+    glDeleteFramebuffers(1, &fbo);
+
+    CpuRasterizer raster(width, height);
+    setRenderBackend(raster);
+    double binMs = 0.0, rasterMs = 0.0;
+    start = std::chrono::steady_clock::now();
+    for(size_t i = 0; i < frames; i++) {
+        raster.clear(0, 0, 0);
+        background.submit();
+        foreground.submit();
+        raster.finish();
+        binMs += raster.lastStats().binMs;
+        rasterMs += raster.lastStats().rasterMs;
+    }
+    double cpuMs = elapsedMs(start) / frames;
+    setRenderBackend(glRenderBackend());
+
+    // per channel difference between the two images
+    size_t differing = 0;
+    double total = 0.0;
+    for(size_t i = 0; i < glPixels.size(); i += 4) {
+        int worst = 0;
+        for(int c = 0; c < 3; c++) worst = std::max(worst, std::abs(glPixels[i + c] - raster.pixels()[i + c]));
+        if(worst > 32) differing++;
+        total += worst;
+    }
+    printf("raster benchmark, %dx%d, %zu vertices, %zu primitives, %zu frames\n",
+           width, height, vertexCount, raster.lastStats().primitives, frames);
+    printf("  gl (%s): %8.2f ms/frame\n", (const char*)glGetString(GL_RENDERER), glMs);
+    printf("  cpu (%u threads, %d px tiles): %8.2f ms/frame (binning %.2f, raster %.2f, %zu bin entries)\n",
+           TaskPool::shared().size(), RASTER_TILE_SIZE, cpuMs, binMs / frames, rasterMs / frames, raster.lastStats().binEntries);
+    printf("  images: mean difference %.3f, %zu pixels off by more than 32\n", total / ((size_t)width * height), differing);
+}
@@ -0,0 +1,14 @@
+#include "renderBackend.h"
+
+RenderStats renderStats;
+
+// set by initGLResources, or by a headless caller before it submits anything
+static RenderBackend* renderBackend = nullptr;
+
+RenderBackend& activeRenderBackend() {
+    return *renderBackend;
+}
+
+void setRenderBackend(RenderBackend& backend) {
+    renderBackend = &backend;
+}
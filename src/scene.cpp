@@ -0,0 +1,317 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "scene.h"
+#include "pappus.h"
+#include "utils.h"
+
+// marker ring of radius 7 around a point, plus its antipode when the point is at infinity (full quality only)
+static void drawMarkerRings(FrameGeometry& frame, double px, double py, float offsetX, float offsetY, Vector3 color) {
+    frame.addCircle(offsetX, offsetY, px, py, 7, color);
+    if(frame.drawExtras && checkInfinityPoint(px, py)) {
+        frame.addCircle(offsetX, offsetY, -px, -py, 7, color);
+    }
+}
+
+static void prepareLayer(const InputState& input, FrameGeometry& frame) {
+    frame.clear();
+    frame.analyticConics = input.analyticConics;
+    frame.tessellationStep = input.tessellationStep;
+    frame.drawExtras = input.drawExtras;
+    frame.view = viewTransform(input.camera, input.viewWidth, input.viewHeight);
+}
+
+static Vector3 markedPointOnSphere(const InputState& input, int idx) {
+    return liftToSphere(std::get<0>(input.markedPoints[idx]), std::get<1>(input.markedPoints[idx]), circleRadius);
+}
+
+// marker colors per correspondence index
+static Vector3 markedPointColor(int j) {
+    // restored original per-index channel variation but with a different base palette
+    float rgbValues[3] = {0.85f, 0.85f, 0.85f};
+    rgbValues[j % 3] = 0.15f; // lower one channel to create distinct color per correspondence
+    return Vector3(rgbValues[0], rgbValues[1], rgbValues[2]);
+}
+
+// FNV-1a over raw bytes
+static void mixKey(uint64_t& hash, const void* data, size_t bytes) {
+    const unsigned char* p = (const unsigned char*)data;
+    for(size_t i = 0; i < bytes; i++) { hash ^= p[i]; hash *= 1099511628211ull; }
+}
+
+// the confirmed points: marked ones and the extra points on the lines
+static uint64_t pointsKey(const InputState& input) {
+    uint64_t hash = 1469598103934665603ull;
+    int confirmed = std::min(input.collectedPoints, 6);
+    for(int j = 0; j < confirmed; j++) {
+        auto [px, py, offX, offY] = input.markedPoints[j];
+        mixKey(hash, &px, sizeof px); mixKey(hash, &py, sizeof py);
+        mixKey(hash, &offX, sizeof offX); mixKey(hash, &offY, sizeof offY);
+    }
+    mixKey(hash, &input.collectedPoints, sizeof input.collectedPoints);
+    mixKey(hash, &input.extraPointsVersion, sizeof input.extraPointsVersion);
+    return hash;
+}
+
+// sphere points of a line's triple followed by its extra points, n per line in all
+static size_t linePointsOnSphere(const InputState& input, Vector3* xs, Vector3* ys) {
+    size_t extra = std::min(input.extraPointCount[0], input.extraPointCount[1]);
+    for(int k = 0; k < 3; k++) {
+        xs[k] = markedPointOnSphere(input, k);
+        ys[k] = markedPointOnSphere(input, 3 + k);
+    }
+    for(size_t k = 0; k < extra; k++) {
+        xs[3 + k] = liftToSphere(std::get<0>(input.extraPoints[0][k]), std::get<1>(input.extraPoints[0][k]), circleRadius);
+        ys[3 + k] = liftToSphere(std::get<0>(input.extraPoints[1][k]), std::get<1>(input.extraPoints[1][k]), circleRadius);
+    }
+    return 3 + extra;
+}
+
+// Pappus configuration of the six marked points; with extra points on the lines the axis is
+// the least-squares fit over all of them, refitted (and reported) only when the points change
+static PappusConfiguration sceneConfiguration(const InputState& input) {
+    Vector3 xs[3] = {markedPointOnSphere(input, 0), markedPointOnSphere(input, 1), markedPointOnSphere(input, 2)};
+    Vector3 ys[3] = {markedPointOnSphere(input, 3), markedPointOnSphere(input, 4), markedPointOnSphere(input, 5)};
+    PappusConfiguration config = computePappus(xs, ys);
+    if(std::min(input.extraPointCount[0], input.extraPointCount[1]) == 0) return config;
+
+    // compute stage only; the key covers the triples too since they can be replaced
+    static AxisFit fit;
+    static uint64_t fitKey = 0;
+    static std::vector<Vector3> lineX(3 + MAX_EXTRA_POINTS), lineY(3 + MAX_EXTRA_POINTS);
+    uint64_t key = pointsKey(input) | 1;
+    if(key != fitKey) {
+        size_t n = linePointsOnSphere(input, lineX.data(), lineY.data());
+        fit = fitPappusAxis(lineX.data(), lineY.data(), n);
+        fitKey = key;
+        printf("axis fit: %zu points per line, %zu intersections, rms residual %.3e, max %.3e, %.2f ms\n",
+               fit.pointsPerLine, fit.intersectionCount, fit.rmsResidual, fit.maxResidual, fit.ms);
+    }
+    GreatCircle axis(fit.axis);
+    config.axis = fit.axis;
+    config.chosen1 = axis.u() * circleRadius;
+    config.chosen2 = axis.v() * circleRadius;
+    return config;
+}
+
+bool drawnPappusAxis(const InputState& input, Vector3& axis) {
+    if(input.collectedPoints < 6) return false;
+    axis = sceneConfiguration(input).axis;
+    return true;
+}
+
+uint64_t backgroundLayerKey(const InputState& input) {
+    // every input the background layer depends on
+    uint64_t hash = pointsKey(input);
+    bool flags[3] = {input.showSupportingLines, input.analyticConics, input.drawExtras};
+    mixKey(hash, flags, sizeof flags);
+    mixKey(hash, &input.tessellationStep, sizeof input.tessellationStep);
+    // culling and the step depend on the view
+    double view[3] = {input.camera.centerX, input.camera.centerY, input.camera.zoom};
+    int viewSize[2] = {input.viewWidth, input.viewHeight};
+    mixKey(hash, view, sizeof view);
+    mixKey(hash, viewSize, sizeof viewSize);
+    return hash | 1; // 0 means no layer
+}
+
+void buildBackgroundLayer(const InputState& input, FrameGeometry& frame) {
+    prepareLayer(input, frame);
+    auto pointOnSphere = [&](int idx) { return markedPointOnSphere(input, idx); };
+
+    // draw first circle (dark gray)
+    frame.addCircle(offsetCircle1X, offsetCircle1Y, 0, 0, circleRadius, Vector3(0.4,0.4,0.4));
+
+    // draw line 1 projected onto first circle
+    if(input.collectedPoints >= 2) {
+        frame.addProjectedLine(pointOnSphere(0), pointOnSphere(1), offsetCircle1X, offsetCircle1Y, circleRadius, Vector3(1,1,1));
+    }
+
+    // draw second circle
+    frame.addCircle(offsetCircle2X, offsetCircle2Y, 0, 0, circleRadius, Vector3(0.4,0.4,0.4));
+
+    // draw line 2 projected onto second circle
+    if(input.collectedPoints >= 5) {
+        frame.addProjectedLine(pointOnSphere(3), pointOnSphere(4), offsetCircle2X, offsetCircle2Y, circleRadius, Vector3(1,1,1));
+    }
+
+    // draw confirmed marked points; the one following the mouse belongs to the foreground
+    for(int j = 0; j < std::min(input.drawablePoints, input.collectedPoints); j++) {
+        auto[px, py, offsetCircleX, offsetCircleY] = input.markedPoints[j];
+        drawMarkerRings(frame, px, py, offsetCircleX, offsetCircleY, markedPointColor(j));
+    }
+
+    // extra points on the lines, as dots: there may be thousands of them
+    frame.appendPoints(input.extraPoints[0], input.extraPointCount[0], offsetCircle1X, offsetCircle1Y, circleRadius, Vector3(0.85,0.85,0.85));
+    frame.appendPoints(input.extraPoints[1], input.extraPointCount[1], offsetCircle2X, offsetCircle2Y, circleRadius, Vector3(0.85,0.85,0.85));
+
+    if(input.collectedPoints >= 6){
+        // all points on the sphere
+        PappusConfiguration config = sceneConfiguration(input);
+        const Vector3* xs = config.x;
+        const Vector3* ys = config.y;
+        const Vector3 &x1 = xs[0], &x2 = xs[1], &x3 = xs[2];
+        const Vector3 &y1 = ys[0], &y2 = ys[1], &y3 = ys[2];
+        Vector3 chosen1 = config.chosen1;
+        Vector3 chosen2 = config.chosen2;
+
+        // Draw supporting lines if enabled (S key toggle); disk by disk so that
+        // strips of the same color on one disk end up in a single draw
+        if(input.showSupportingLines && input.drawExtras) {
+            const Vector3* supportingLines[6][2] = {
+                {&x1, &y2}, {&y1, &x2}, {&x3, &y1}, {&y3, &x1}, {&x2, &y3}, {&y2, &x3}
+            };
+            for(int disk = 0; disk < 2; disk++) {
+                float offX = disk == 0 ? offsetCircle1X : offsetCircle2X;
+                float offY = disk == 0 ? offsetCircle1Y : offsetCircle2Y;
+                for(auto& ends : supportingLines) {
+                    frame.addProjectedLine(*ends[0], *ends[1], offX, offY, circleRadius, Vector3(0.2,0.2,0.2));
+                }
+            }
+        }
+
+    
+
+        //draw pappus
+
+
+        // draw only the arc (no opposite-side vertices) for pappus support lines
+        frame.addProjectedLine(chosen1, chosen2, offsetCircle1X, offsetCircle1Y, circleRadius, Vector3(0.5,1,0.5), true);
+        frame.addProjectedLine(chosen1, chosen2, offsetCircle2X, offsetCircle2Y, circleRadius, Vector3(0.5,1,0.5), true);
+    }
+
+    frame.build(TaskPool::shared());
+}
+
+void buildForegroundLayer(const InputState& input, FrameGeometry& frame) {
+    prepareLayer(input, frame);
+
+    // the point being placed follows the mouse
+    for(int j = input.collectedPoints; j < input.drawablePoints; j++) {
+        auto[px, py, offsetCircleX, offsetCircleY] = input.markedPoints[j];
+        drawMarkerRings(frame, px, py, offsetCircleX, offsetCircleY, markedPointColor(j));
+    }
+
+    // extra point about to be added to a line
+    if(input.extraCandidateLine != -1) {
+        auto [px, py] = input.extraCandidate;
+        float offsetX = input.extraCandidateLine == 0 ? offsetCircle1X : offsetCircle2X;
+        float offsetY = input.extraCandidateLine == 0 ? offsetCircle1Y : offsetCircle2Y;
+        drawMarkerRings(frame, px, py, offsetX, offsetY, Vector3(0.85,0.85,0.85));
+    }
+
+    if(input.collectedPoints >= 6) {
+        PappusConfiguration config = sceneConfiguration(input);
+
+        //draw interactive point
+         if (input.canDrawInteractivePoint) {
+             auto[px, py] = input.interactivePoint;
+             // interactive point circle on first circle (green)
+            drawMarkerRings(frame, px, py, offsetCircle1X, offsetCircle1Y, Vector3(0,1,0));
+
+            // draw the image point and related projected lines
+            Vector3 itp = liftToSphere(px, py, circleRadius);
+            PappusImage correspondence = pappusImage(config, itp);
+            const Vector3& chosenpoint1 = correspondence.center1;
+            const Vector3& pappusIntersection = correspondence.axisPoint;
+            const Vector3& imagePoint = correspondence.image;
+
+            // projected line from chosenpoint1 to itp on circle1
+            frame.addProjectedLine(chosenpoint1, itp, offsetCircle1X, offsetCircle1Y, circleRadius, Vector3(0.5,0.5,1));
+
+            // projected line for pappusIntersection -> imagePoint on circle2
+            frame.addProjectedLine(pappusIntersection, imagePoint, offsetCircle2X, offsetCircle2Y, circleRadius, Vector3(0.5,0.5,1));
+
+            // draw pappus intersection marker circles on both circles (dark gray)
+             {
+                 auto [rx, ry, rz] = pappusIntersection;
+                drawMarkerRings(frame, rx, ry, offsetCircle1X, offsetCircle1Y, Vector3(0.1,0.1,0.1));
+                drawMarkerRings(frame, rx, ry, offsetCircle2X, offsetCircle2Y, Vector3(0.1,0.1,0.1));
+             }
+
+            // draw image point on second circle (use same orange as interactive point)
+             {
+                 auto [qx, qy, qz] = imagePoint;
+                drawMarkerRings(frame, qx, qy, offsetCircle2X, offsetCircle2Y, Vector3(0,1,0));
+             }
+        }
+    }
+
+    frame.build(TaskPool::shared());
+}
+
+static void setLabel(TextLabel& label, const char* text, double x, double y, Vector3 color) {
+    snprintf(label.text, sizeof label.text, "%s", text);
+    label.x = x;
+    label.y = y;
+    label.color[0] = (float)color[0]; label.color[1] = (float)color[1]; label.color[2] = (float)color[2];
+}
+
+int buildSceneLabels(const InputState& input, TextLabel* labels) {
+    static const char* pointNames[6] = {"x1", "x2", "x3", "y1", "y2", "y3"};
+    int count = 0;
+    for(int j = 0; j < std::min(input.drawablePoints, 6); j++) {
+        auto [px, py, offX, offY] = input.markedPoints[j];
+        setLabel(labels[count++], pointNames[j], px + offX, py + offY, markedPointColor(j));
+    }
+    if(input.collectedPoints < 6) return count;
+
+    // the intersections span the Pappus line, on both disks and on the visible hemisphere
+    static const char* intersectionNames[3] = {"p12", "p13", "p23"};
+    PappusConfiguration config = sceneConfiguration(input);
+    for(int k = 0; k < 3; k++) {
+        Vector3 p = config.intersections[k];
+        if(p[2] < 0) p = p * -1.0;
+        setLabel(labels[count++], intersectionNames[k], p[0] + offsetCircle1X, p[1] + offsetCircle1Y, Vector3(0.6,0.6,0.6));
+        setLabel(labels[count++], intersectionNames[k], p[0] + offsetCircle2X, p[1] + offsetCircle2Y, Vector3(0.6,0.6,0.6));
+    }
+    return count;
+}
+
+bool interactiveCorrespondence(const InputState& input, double out[4]) {
+    if(input.collectedPoints < 6 || !input.canDrawInteractivePoint) return false;
+    auto [px, py] = input.interactivePoint;
+    Vector3 image = pappusImage(sceneConfiguration(input), liftToSphere(px, py, circleRadius)).image;
+    out[0] = px;
+    out[1] = py;
+    out[2] = image[0];
+    out[3] = image[1];
+    return true;
+}
+
+void buildRecordScene(const double* values, int valueCount, int width, int height,
+                      FrameGeometry& background, FrameGeometry& foreground) {
+    static InputState input;
+    input = InputState();
+    for(int k = 0; k < 3; k++) {
+        input.markedPoints[k] = std::make_tuple(values[2 * k], values[2 * k + 1], offsetCircle1X, offsetCircle1Y);
+        input.markedPoints[3 + k] = std::make_tuple(values[6 + 2 * k], values[7 + 2 * k], offsetCircle2X, offsetCircle2Y);
+    }
+    input.collectedPoints = input.drawablePoints = 6;
+    input.showSupportingLines = true;
+    if(valueCount >= 14) {
+        input.interactivePoint = std::make_tuple(values[12], values[13]);
+        input.canDrawInteractivePoint = true;
+    }
+    input.viewWidth = width;
+    input.viewHeight = height;
+    buildBackgroundLayer(input, background);
+    buildForegroundLayer(input, foreground);
+}
+
+int readSceneRecord(FILE* in, double values[SCENE_RECORD_VALUES]) {
+    char line[4096];
+    while(fgets(line, sizeof line, in)) {
+        char* cursor = line;
+        int count = 0;
+        while(count < SCENE_RECORD_VALUES) {
+            char* end;
+            double value = strtod(cursor, &end);
+            if(end == cursor) break;
+            values[count++] = value;
+            cursor = end;
+        }
+        if(count > 0) return count;
+    }
+    return 0;
+}
@@ -0,0 +1,263 @@
+#include <GL/glew.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include "snapping.h"
+#include "camera.h"
+#include "pappus.h"
+#include "utils.h"
+
+bool snappingEnabled = true;
+
+uint64_t SpatialHash::cellKey(long cx, long cy) const {
+    return ((uint64_t)(uint32_t)cx << 32) | (uint32_t)cy;
+}
+
+long SpatialHash::cellOf(double v) const {
+    return (long)std::floor(v / cellSize);
+}
+
+void SpatialHash::insert(uint32_t id, Feature& feature) {
+    if(!feature.isLine) {
+        uint64_t key = cellKey(cellOf(feature.xy[0]), cellOf(feature.xy[1]));
+        cells[key].push_back({id, 0});
+        feature.cells.push_back(key);
+        return;
+    }
+    // every cell under the box of each segment; segments are shorter than a cell or two
+    size_t segments = feature.xy.size() / 2 - 1;
+    for(size_t s = 0; s < segments; s++) {
+        const double* a = &feature.xy[2 * s];
+        long cx0 = cellOf(std::min(a[0], a[2])), cx1 = cellOf(std::max(a[0], a[2]));
+        long cy0 = cellOf(std::min(a[1], a[3])), cy1 = cellOf(std::max(a[1], a[3]));
+        for(long cy = cy0; cy <= cy1; cy++) {
+            for(long cx = cx0; cx <= cx1; cx++) {
+                uint64_t key = cellKey(cx, cy);
+                cells[key].push_back({id, (uint32_t)s});
+                feature.cells.push_back(key);
+            }
+        }
+    }
+    std::sort(feature.cells.begin(), feature.cells.end());
+    feature.cells.erase(std::unique(feature.cells.begin(), feature.cells.end()), feature.cells.end());
+}
+
+void SpatialHash::setPoint(uint32_t id, double x, double y) {
+    auto found = features.find(id);
+    if(found != features.end() && !found->second.isLine && found->second.xy[0] == x && found->second.xy[1] == y) return;
+    remove(id);
+    Feature& feature = features[id];
+    feature.xy = {x, y};
+    insert(id, feature);
+}
+
+void SpatialHash::setLine(uint32_t id, const Vector3& normal, double radius) {
+    // compared as given: the same inputs always give bit-identical normals
+    auto found = features.find(id);
+    if(found != features.end() && found->second.isLine && found->second.normal[0] == normal[0]
+       && found->second.normal[1] == normal[1] && found->second.normal[2] == normal[2]) return;
+    remove(id);
+    GreatCircle line(normal);
+    Feature& feature = features[id];
+    feature.isLine = true;
+    feature.normal = normal;
+    // the upper half circle, which is what the disk shows
+    feature.xy.resize(2 * (SNAP_LINE_SEGMENTS + 1));
+    for(int k = 0; k <= SNAP_LINE_SEGMENTS; k++) {
+        double t = k * M_PI / SNAP_LINE_SEGMENTS;
+        Vector3 p = (line.u() * cos(t) + line.v() * sin(t)) * radius;
+        feature.xy[2 * k] = p[0];
+        feature.xy[2 * k + 1] = p[1];
+    }
+    insert(id, feature);
+}
+
+void SpatialHash::remove(uint32_t id) {
+    auto found = features.find(id);
+    if(found == features.end()) return;
+    for(uint64_t key : found->second.cells) {
+        auto cell = cells.find(key);
+        if(cell == cells.end()) continue;
+        std::vector<Entry>& entries = cell->second;
+        entries.erase(std::remove_if(entries.begin(), entries.end(), [&](const Entry& e) { return e.feature == id; }), entries.end());
+        if(entries.empty()) cells.erase(cell);
+    }
+    features.erase(found);
+}
+
+void SpatialHash::clear() {
+    cells.clear();
+    features.clear();
+}
+
+SpatialHash::Hit SpatialHash::nearest(double x, double y, double tolerance, uint32_t excludeId) const {
+    Hit point, line;
+    double pointDistance = tolerance, lineDistance = tolerance;
+    for(long cy = cellOf(y - tolerance); cy <= cellOf(y + tolerance); cy++) {
+        for(long cx = cellOf(x - tolerance); cx <= cellOf(x + tolerance); cx++) {
+            auto cell = cells.find(cellKey(cx, cy));
+            if(cell == cells.end()) continue;
+            for(const Entry& entry : cell->second) {
+                if(entry.feature == excludeId) continue;
+                const Feature& feature = features.at(entry.feature);
+                if(!feature.isLine) {
+                    double d = std::hypot(feature.xy[0] - x, feature.xy[1] - y);
+                    if(d <= pointDistance) {
+                        pointDistance = d;
+                        point.found = true;
+                        point.id = entry.feature;
+                        point.x = feature.xy[0];
+                        point.y = feature.xy[1];
+                    }
+                    continue;
+                }
+                // closest position on the segment
+                const double* a = &feature.xy[2 * entry.segment];
+                double dx = a[2] - a[0], dy = a[3] - a[1];
+                double length2 = dx * dx + dy * dy;
+                double t = length2 > 0 ? std::clamp(((x - a[0]) * dx + (y - a[1]) * dy) / length2, 0.0, 1.0) : 0.0;
+                double px = a[0] + t * dx, py = a[1] + t * dy;
+                double d = std::hypot(px - x, py - y);
+                if(d <= lineDistance) {
+                    lineDistance = d;
+                    line.found = true;
+                    line.isLine = true;
+                    line.id = entry.feature;
+                    line.x = px;
+                    line.y = py;
+                    line.normal = feature.normal;
+                }
+            }
+        }
+    }
+    return point.found ? point : line;
+}
+
+// ---- Features of the construction ----
+
+// ids inside the index of one disk
+enum SnapFeature : uint32_t {
+    SNAP_MARKED = 0,             // the disk's three marked points
+    SNAP_MARKED_ANTIPODE = 3,    // their antipodes, for points at infinity
+    SNAP_BASE_LINE = 6,
+    SNAP_INTERSECTION = 7,       // x1y2.x2y1, x1y3.x3y1, x2y3.y2x3
+    SNAP_INTERSECTION_ANTIPODE = 10,
+    SNAP_AXIS = 13,
+    SNAP_EXTRA = 16              // extra points on the line, in order
+};
+
+static SpatialHash diskIndex[2];
+static int indexedExtraPoints[2] = {};
+
+// a point and, when it lies on the rim, the antipode the markers show as well
+static void setPointPair(SpatialHash& index, uint32_t id, uint32_t antipodeId, double x, double y) {
+    index.setPoint(id, x, y);
+    if(checkInfinityPoint(x, y)) index.setPoint(antipodeId, -x, -y);
+    else index.remove(antipodeId);
+}
+
+void updateSnapFeatures() {
+    bool complete = collectedPoints >= 6;
+    PappusConfiguration config;
+    if(complete) {
+        Vector3 xs[3], ys[3];
+        for(int k = 0; k < 3; k++) {
+            xs[k] = liftToSphere(std::get<0>(markedPoints[k]), std::get<1>(markedPoints[k]), circleRadius);
+            ys[k] = liftToSphere(std::get<0>(markedPoints[3 + k]), std::get<1>(markedPoints[3 + k]), circleRadius);
+        }
+        config = computePappus(xs, ys);
+    }
+
+    for(int disk = 0; disk < 2; disk++) {
+        SpatialHash& index = diskIndex[disk];
+        for(int k = 0; k < 3; k++) {
+            int j = 3 * disk + k;
+            if(j < collectedPoints) {
+                setPointPair(index, SNAP_MARKED + k, SNAP_MARKED_ANTIPODE + k, std::get<0>(markedPoints[j]), std::get<1>(markedPoints[j]));
+            }
+            else {
+                index.remove(SNAP_MARKED + k);
+                index.remove(SNAP_MARKED_ANTIPODE + k);
+            }
+        }
+        if(collectedPoints >= 2 + 3 * disk) index.setLine(SNAP_BASE_LINE, baseLines[disk].normal(), circleRadius);
+        else index.remove(SNAP_BASE_LINE);
+
+        // the intersections of the six marked points, on both disks
+        for(int k = 0; k < 3; k++) {
+            if(complete) {
+                Vector3 p = config.intersections[k];
+                if(p[2] < 0) p = p * -1.0;
+                setPointPair(index, SNAP_INTERSECTION + k, SNAP_INTERSECTION_ANTIPODE + k, p[0], p[1]);
+            }
+            else {
+                index.remove(SNAP_INTERSECTION + k);
+                index.remove(SNAP_INTERSECTION_ANTIPODE + k);
+            }
+        }
+
+        // extra points are only ever appended, so only the new ones are indexed
+        for(int k = indexedExtraPoints[disk]; k < extraPointCount[disk]; k++) {
+            index.setPoint(SNAP_EXTRA + k, std::get<0>(extraPoints[disk][k]), std::get<1>(extraPoints[disk][k]));
+        }
+        for(int k = extraPointCount[disk]; k < indexedExtraPoints[disk]; k++) index.remove(SNAP_EXTRA + k);
+        indexedExtraPoints[disk] = extraPointCount[disk];
+    }
+}
+
+void updateSnapAxis(uint64_t backgroundKey, bool hasAxis, const Vector3& axis) {
+    // the key changes with every edit of the points, so a refitted axis is picked up as well
+    static uint64_t indexedKey = 0;
+    if(backgroundKey == indexedKey) return;
+    indexedKey = backgroundKey;
+    for(int disk = 0; disk < 2; disk++) {
+        if(hasAxis) diskIndex[disk].setLine(SNAP_AXIS, axis, circleRadius);
+        else diskIndex[disk].remove(SNAP_AXIS);
+    }
+}
+
+static double snapTolerance() {
+    return SNAP_TOLERANCE_PIXELS * currentView().pixelSize;
+}
+
+bool snapFreePoint(int disk, double& x, double& y) {
+    if(!snappingEnabled) return false;
+    SpatialHash::Hit hit = diskIndex[disk].nearest(x, y, snapTolerance());
+    if(!hit.found) return false;
+    if(hit.isLine) {
+        Vector3 p = GreatCircle(hit.normal).project(x, y, circleRadius);
+        x = p[0];
+        y = p[1];
+        return true;
+    }
+    x = hit.x;
+    y = hit.y;
+    return true;
+}
+
+bool snapOnBaseLine(int disk, double& x, double& y) {
+    if(!snappingEnabled) return false;
+    double tolerance = snapTolerance();
+    SpatialHash::Hit hit = diskIndex[disk].nearest(x, y, tolerance, SNAP_BASE_LINE);
+    if(!hit.found) return false;
+    if(!hit.isLine) {
+        x = hit.x;
+        y = hit.y;
+        return true;
+    }
+    // where the two lines cross, on the upper hemisphere; nearly parallel lines cross far away
+    Vector3 crossing = baseLines[disk].normal().cross(hit.normal);
+    if(crossing.dot(crossing) == 0) return false;
+    crossing = crossing.normalize() * circleRadius;
+    if(crossing[2] < 0) crossing = crossing * -1.0;
+    if(std::hypot(crossing[0] - x, crossing[1] - y) > 2 * tolerance) return false;
+    x = crossing[0];
+    y = crossing[1];
+    return true;
+}
+
+void toggleSnapping() {
+    snappingEnabled = !snappingEnabled;
+    printf("snapping %s: %zu features on the first disk, %zu on the second\n", snappingEnabled ? "on" : "off",
+           diskIndex[0].featureCount(), diskIndex[1].featureCount());
+}
@@ -0,0 +1,39 @@
+#include <GL/glew.h>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+#include "startupTiming.h"
+#include "programCache.h"
+
+static std::chrono::steady_clock::time_point startupStart;
+static std::chrono::steady_clock::time_point lastMark;
+static std::vector<std::pair<std::string, double>> phases;
+static bool reported = false;
+
+static double millisecondsSince(std::chrono::steady_clock::time_point from) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - from).count();
+}
+
+void startStartupTiming() {
+    startupStart = lastMark = std::chrono::steady_clock::now();
+}
+
+void markStartupPhase(const char* name) {
+    phases.emplace_back(name, millisecondsSince(lastMark));
+    lastMark = std::chrono::steady_clock::now();
+}
+
+void noteFramePresented(bool hasContent) {
+    if(reported || !hasContent) return;
+    // wait for the frame to actually reach the window before stopping the clock
+    glFinish();
+    markStartupPhase("first frame");
+    reported = true;
+
+    printf("startup (shader cache %s):", useProgramCache ? "on" : "off");
+    for(const auto& [name, ms] : phases) printf(" %s %.1f ms,", name.c_str(), ms);
+    printf(" total %.1f ms; programs %d from cache, %d compiled\n",
+           millisecondsSince(startupStart), programCacheHits, programCacheMisses);
+}
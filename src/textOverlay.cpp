@@ -0,0 +1,168 @@
+#include <GL/glew.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include "textOverlay.h"
+#include "graphics.h"
+#include "utils.h"
+
+bool showTextOverlay = true;
+
+// 5x7 bitmap font, one byte per row from the top, bit 4 is the leftmost column
+struct GlyphBitmap {
+    char c;
+    unsigned char rows[7];
+};
+static const GlyphBitmap FONT[] = {
+    {' ', {0x00,0x00,0x00,0x00,0x00,0x00,0x00}}, {'%', {0x18,0x19,0x02,0x04,0x08,0x13,0x03}},
+    {'(', {0x02,0x04,0x08,0x08,0x08,0x04,0x02}}, {')', {0x08,0x04,0x02,0x02,0x02,0x04,0x08}},
+    {',', {0x00,0x00,0x00,0x00,0x0C,0x04,0x08}}, {'-', {0x00,0x00,0x00,0x1F,0x00,0x00,0x00}},
+    {'.', {0x00,0x00,0x00,0x00,0x00,0x0C,0x0C}}, {'/', {0x00,0x01,0x02,0x04,0x08,0x10,0x00}},
+    {'0', {0x0E,0x11,0x13,0x15,0x19,0x11,0x0E}}, {'1', {0x04,0x0C,0x04,0x04,0x04,0x04,0x0E}},
+    {'2', {0x0E,0x11,0x01,0x02,0x04,0x08,0x1F}}, {'3', {0x1F,0x02,0x04,0x02,0x01,0x11,0x0E}},
+    {'4', {0x02,0x06,0x0A,0x12,0x1F,0x02,0x02}}, {'5', {0x1F,0x10,0x1E,0x01,0x01,0x11,0x0E}},
+    {'6', {0x06,0x08,0x10,0x1E,0x11,0x11,0x0E}}, {'7', {0x1F,0x01,0x02,0x04,0x08,0x08,0x08}},
+    {'8', {0x0E,0x11,0x11,0x0E,0x11,0x11,0x0E}}, {'9', {0x0E,0x11,0x11,0x0F,0x01,0x02,0x0C}},
+    {':', {0x00,0x0C,0x0C,0x00,0x0C,0x0C,0x00}}, {'=', {0x00,0x00,0x1F,0x00,0x1F,0x00,0x00}},
+    {'a', {0x00,0x00,0x0E,0x01,0x0F,0x11,0x0F}}, {'b', {0x10,0x10,0x16,0x19,0x11,0x11,0x1E}},
+    {'c', {0x00,0x00,0x0E,0x10,0x10,0x11,0x0E}}, {'d', {0x01,0x01,0x0D,0x13,0x11,0x11,0x0F}},
+    {'e', {0x00,0x00,0x0E,0x11,0x1F,0x10,0x0E}}, {'f', {0x06,0x09,0x08,0x1C,0x08,0x08,0x08}},
+    {'g', {0x00,0x0F,0x11,0x11,0x0F,0x01,0x0E}}, {'h', {0x10,0x10,0x16,0x19,0x11,0x11,0x11}},
+    {'i', {0x04,0x00,0x0C,0x04,0x04,0x04,0x0E}}, {'j', {0x02,0x00,0x06,0x02,0x02,0x12,0x0C}},
+    {'k', {0x10,0x10,0x12,0x14,0x18,0x14,0x12}}, {'l', {0x0C,0x04,0x04,0x04,0x04,0x04,0x0E}},
+    {'m', {0x00,0x00,0x1A,0x15,0x15,0x11,0x11}}, {'n', {0x00,0x00,0x16,0x19,0x11,0x11,0x11}},
+    {'o', {0x00,0x00,0x0E,0x11,0x11,0x11,0x0E}}, {'p', {0x00,0x00,0x1E,0x11,0x1E,0x10,0x10}},
+    {'q', {0x00,0x00,0x0D,0x13,0x0F,0x01,0x01}}, {'r', {0x00,0x00,0x16,0x19,0x10,0x10,0x10}},
+    {'s', {0x00,0x00,0x0E,0x10,0x0E,0x01,0x1E}}, {'t', {0x08,0x08,0x1C,0x08,0x08,0x09,0x06}},
+    {'u', {0x00,0x00,0x11,0x11,0x11,0x13,0x0D}}, {'v', {0x00,0x00,0x11,0x11,0x11,0x0A,0x04}},
+    {'w', {0x00,0x00,0x11,0x11,0x15,0x15,0x0A}}, {'x', {0x00,0x00,0x11,0x0A,0x04,0x0A,0x11}},
+    {'y', {0x00,0x00,0x11,0x11,0x0F,0x01,0x0E}}, {'z', {0x00,0x00,0x1F,0x02,0x04,0x08,0x1F}},
+};
+static const int GLYPH_COUNT = sizeof(FONT) / sizeof(FONT[0]);
+
+// atlas cells: every font pixel covers FONT_TEXELS texels, with room around the glyph for the
+// distance ramp; distances are stored as 0.5 - d / (2 * SPREAD_TEXELS), so the edge is at 0.5
+static const int FONT_TEXELS = 4;
+static const int CELL_PADDING = 6;
+static const int CELL_WIDTH = 5 * FONT_TEXELS + 2 * CELL_PADDING;
+static const int CELL_HEIGHT = 7 * FONT_TEXELS + 2 * CELL_PADDING;
+static const float SPREAD_TEXELS = 6.0f;
+static const int ATLAS_COLUMNS = 8;
+static const int ATLAS_ROWS = (GLYPH_COUNT + ATLAS_COLUMNS - 1) / ATLAS_COLUMNS;
+
+// on screen: window pixels per font pixel, pen advance and line height in window pixels
+static const double TEXT_SCALE = 2.0;
+static const double GLYPH_ADVANCE = 6 * TEXT_SCALE;
+static const double LINE_HEIGHT = 10 * TEXT_SCALE;
+
+static GLuint atlasTexture = 0;
+static int glyphSlot[128];
+// x, y, r, g, b, u, v per vertex, six vertices per glyph; reused across frames
+static std::vector<float> vertices;
+
+static bool fontPixel(const GlyphBitmap& glyph, int column, int row) {
+    if(column < 0 || column >= 5 || row < 0 || row >= 7) return false;
+    return (glyph.rows[row] >> (4 - column)) & 1;
+}
+
+// exact signed distance, in texels, from the texel center to the union of lit font pixels
+static float glyphDistance(const GlyphBitmap& glyph, float x, float y) {
+    // font pixel under the texel, the outer ring of empty pixels stands for everything outside
+    float fx = (x - CELL_PADDING) / FONT_TEXELS, fy = (y - CELL_PADDING) / FONT_TEXELS;
+    bool inside = fontPixel(glyph, (int)std::floor(fx), (int)std::floor(fy));
+    float best = 1e9f;
+    for(int row = -1; row <= 7; row++) {
+        for(int column = -1; column <= 5; column++) {
+            if(fontPixel(glyph, column, row) == inside) continue;
+            // distance to the square of the opposite kind
+            float dx = std::max({column - fx, 0.0f, fx - (column + 1)});
+            float dy = std::max({row - fy, 0.0f, fy - (row + 1)});
+            best = std::min(best, std::sqrt(dx * dx + dy * dy));
+        }
+    }
+    float texels = best * FONT_TEXELS;
+    return inside ? -texels : texels;
+}
+
+void initTextOverlay() {
+    int width = ATLAS_COLUMNS * CELL_WIDTH, height = ATLAS_ROWS * CELL_HEIGHT;
+    std::vector<unsigned char> atlas(width * height, 0);
+    for(int g = 0; g < GLYPH_COUNT; g++) {
+        int cellX = (g % ATLAS_COLUMNS) * CELL_WIDTH, cellY = (g / ATLAS_COLUMNS) * CELL_HEIGHT;
+        for(int y = 0; y < CELL_HEIGHT; y++) {
+            for(int x = 0; x < CELL_WIDTH; x++) {
+                float d = glyphDistance(FONT[g], x + 0.5f, y + 0.5f);
+                float value = std::clamp(0.5f - d / (2 * SPREAD_TEXELS), 0.0f, 1.0f);
+                atlas[(cellY + y) * width + cellX + x] = (unsigned char)std::lround(value * 255);
+            }
+        }
+    }
+    std::fill(glyphSlot, glyphSlot + 128, 0); // unknown characters show as blanks
+    for(int g = 0; g < GLYPH_COUNT; g++) glyphSlot[(int)FONT[g].c] = g;
+
+    glGenTextures(1, &atlasTexture);
+    glBindTexture(GL_TEXTURE_2D, atlasTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, width, height, 0, GL_RED, GL_UNSIGNED_BYTE, atlas.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+// one line of text whose first glyph box has its bottom left corner at (x, y), camera-relative world units
+static void appendText(const char* text, double x, double y, double pixelSize, const float color[3]) {
+    double unit = TEXT_SCALE / FONT_TEXELS * pixelSize; // world units per atlas texel
+    double quadWidth = CELL_WIDTH * unit, quadHeight = CELL_HEIGHT * unit;
+    float atlasWidth = ATLAS_COLUMNS * CELL_WIDTH, atlasHeight = ATLAS_ROWS * CELL_HEIGHT;
+    for(const char* c = text; *c; c++, x += GLYPH_ADVANCE * pixelSize) {
+        if(*c == ' ') continue;
+        int slot = glyphSlot[(unsigned char)*c & 127];
+        float u0 = (slot % ATLAS_COLUMNS) * CELL_WIDTH / atlasWidth;
+        float u1 = u0 + CELL_WIDTH / atlasWidth;
+        // atlas rows run from the top of the glyph down
+        float vTop = (slot / ATLAS_COLUMNS) * CELL_HEIGHT / atlasHeight;
+        float vBottom = vTop + CELL_HEIGHT / atlasHeight;
+        float left = (float)(x - CELL_PADDING * unit), right = (float)(left + quadWidth);
+        float bottom = (float)(y - CELL_PADDING * unit), top = (float)(bottom + quadHeight);
+        const float quad[6][4] = {
+            {left, bottom, u0, vBottom}, {right, bottom, u1, vBottom}, {right, top, u1, vTop},
+            {left, bottom, u0, vBottom}, {right, top, u1, vTop}, {left, top, u0, vTop},
+        };
+        for(const float* v : quad) {
+            vertices.insert(vertices.end(), {v[0], v[1], color[0], color[1], color[2], v[2], v[3]});
+        }
+    }
+}
+
+void drawTextOverlay(const TextLabel* labels, int labelCount, const ViewTransform& view, const char* hud) {
+    if(!showTextOverlay) return;
+    vertices.clear();
+    double pixelSize = view.pixelSize;
+    for(int i = 0; i < labelCount; i++) {
+        const TextLabel& label = labels[i];
+        // up and to the right of the point, clear of its marker ring
+        appendText(label.text, label.x - view.centerX + 9 * pixelSize, label.y - view.centerY + 7 * pixelSize,
+                   pixelSize, label.color);
+    }
+    if(hud) {
+        static const float hudColor[3] = {0.85f, 0.85f, 0.85f};
+        double left = -view.halfWidth() + 10 * pixelSize;
+        double baseline = view.halfHeight() - (10 + 7 * TEXT_SCALE) * pixelSize;
+        char line[128];
+        for(const char* start = hud; *start; ) {
+            const char* end = strchr(start, '\n');
+            size_t length = std::min(end ? (size_t)(end - start) : strlen(start), sizeof line - 1);
+            memcpy(line, start, length);
+            line[length] = '\0';
+            appendText(line, left, baseline, pixelSize, hudColor);
+            baseline -= LINE_HEIGHT * pixelSize;
+            if(!end) break;
+            start = end + 1;
+        }
+    }
+    drawGlyphQuads(vertices.data(), vertices.size(), view, atlasTexture);
+}
@@ -0,0 +1,137 @@
+#include <GL/glew.h>
+#include <GL/glut.h>
+#include <algorithm>
+#include <cstddef>
+#include "trail.h"
+#include "graphics.h"
+#include "utils.h"
+
+bool showTrail = true;
+
+// one ring slot; serial counts appends since the trail was cleared
+struct TrailEntry {
+    float point[2];
+    float image[2];
+    GLuint serial;
+};
+
+// dot radius in pixels
+static const float TRAIL_DOT_RADIUS = 3.0f;
+
+static GLuint trailProgram = 0, trailVao = 0, trailVbo = 0;
+static GLint uni_uTrailView = -1;
+static GLint uni_uDisk1 = -1, uni_uDisk2 = -1;
+static GLint uni_uDotSize = -1;
+static GLint uni_uHead = -1;
+static GLint uni_uCapacity = -1;
+static GLuint head = 0; // serial of the next entry
+
+// two dots per instance, six vertices each, placed from gl_VertexID: no per-vertex data at all
+static const char* trailVertexShaderSrc = R"glsl(
+#version 330 core
+layout(location = 0) in vec2 inPoint;  // per instance, disk coordinates on the first disk
+layout(location = 1) in vec2 inImage;  // and on the second one
+layout(location = 2) in uint inSerial;
+uniform mat3 uView;
+uniform vec2 uDisk1, uDisk2;           // disk centers relative to the view center
+uniform float uDotSize;                // dot radius in world units
+uniform uint uHead;
+uniform float uCapacity;
+out vec2 corner;
+out float fade;
+flat out int isImage;
+const vec2 CORNERS[6] = vec2[6](vec2(-1, -1), vec2(1, -1), vec2(1, 1), vec2(-1, -1), vec2(1, 1), vec2(-1, 1));
+void main() {
+    isImage = gl_VertexID / 6;
+    corner = CORNERS[gl_VertexID % 6];
+    vec2 center = isImage == 1 ? uDisk2 + inImage : uDisk1 + inPoint;
+    gl_Position = vec4((uView * vec3(center + corner * uDotSize, 1.0)).xy, 0.0, 1.0);
+    // 0 for the newest entry, close to 1 for the oldest still in the ring
+    float age = float(uHead - 1u - inSerial) / uCapacity;
+    fade = 1.0 - age;
+}
+)glsl";
+
+static const char* trailFragmentShaderSrc = R"glsl(
+#version 330 core
+in vec2 corner;
+in float fade;
+flat in int isImage;
+out vec4 outColor;
+void main() {
+    float coverage = smoothstep(1.0, 0.75, length(corner));
+    // from the marker green of the current point towards blue as entries age
+    vec3 color = mix(vec3(0.1, 0.3, 1.0), vec3(0.0, 1.0, 0.0), fade);
+    if(isImage == 1) color = color.bgr;
+    outColor = vec4(color, coverage * fade * fade * 0.8);
+}
+)glsl";
+
+void initTrailResources() {
+    trailProgram = buildProgram(trailVertexShaderSrc, trailFragmentShaderSrc);
+    uni_uTrailView = glGetUniformLocation(trailProgram, "uView");
+    uni_uDisk1 = glGetUniformLocation(trailProgram, "uDisk1");
+    uni_uDisk2 = glGetUniformLocation(trailProgram, "uDisk2");
+    uni_uDotSize = glGetUniformLocation(trailProgram, "uDotSize");
+    uni_uHead = glGetUniformLocation(trailProgram, "uHead");
+    uni_uCapacity = glGetUniformLocation(trailProgram, "uCapacity");
+
+    // allocated once at full capacity, then only written one slot at a time
+    glGenBuffers(1, &trailVbo);
+    glBindBuffer(GL_ARRAY_BUFFER, trailVbo);
+    glBufferData(GL_ARRAY_BUFFER, TRAIL_CAPACITY * sizeof(TrailEntry), nullptr, GL_DYNAMIC_DRAW);
+
+    glGenVertexArrays(1, &trailVao);
+    glBindVertexArray(trailVao);
+    GLsizei stride = sizeof(TrailEntry);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(TrailEntry, point));
+    glVertexAttribDivisor(0, 1);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(TrailEntry, image));
+    glVertexAttribDivisor(1, 1);
+    glEnableVertexAttribArray(2);
+    glVertexAttribIPointer(2, 1, GL_UNSIGNED_INT, stride, (void*)offsetof(TrailEntry, serial));
+    glVertexAttribDivisor(2, 1);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void appendTrail(double pointX, double pointY, double imageX, double imageY) {
+    TrailEntry entry = {{(float)pointX, (float)pointY}, {(float)imageX, (float)imageY}, head};
+    glBindBuffer(GL_ARRAY_BUFFER, trailVbo);
+    glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)((head % TRAIL_CAPACITY) * sizeof(TrailEntry)), sizeof entry, &entry);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    head++;
+}
+
+void clearTrail() {
+    // the slots are rewritten before they are drawn again
+    head = 0;
+}
+
+void drawTrail(const ViewTransform& view) {
+    if(!showTrail || head == 0) return;
+    glUseProgram(trailProgram);
+    if(uni_uTrailView != -1) {
+        float m[9];
+        view.relativeMatrix(m);
+        glUniformMatrix3fv(uni_uTrailView, 1, GL_FALSE, m);
+    }
+    if(uni_uDisk1 != -1) glUniform2f(uni_uDisk1, (float)(offsetCircle1X - view.centerX), (float)(offsetCircle1Y - view.centerY));
+    if(uni_uDisk2 != -1) glUniform2f(uni_uDisk2, (float)(offsetCircle2X - view.centerX), (float)(offsetCircle2Y - view.centerY));
+    if(uni_uDotSize != -1) glUniform1f(uni_uDotSize, (float)(TRAIL_DOT_RADIUS * view.pixelSize));
+    if(uni_uHead != -1) glUniform1ui(uni_uHead, head);
+    if(uni_uCapacity != -1) glUniform1f(uni_uCapacity, (float)TRAIL_CAPACITY);
+    glBindVertexArray(trailVao);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 12, (GLsizei)std::min<GLuint>(head, TRAIL_CAPACITY));
+    renderStats.drawCalls++;
+    glBindVertexArray(0);
+    glUseProgram(0);
+}
+
+void toggleTrail() {
+    showTrail = !showTrail;
+    if(!showTrail) clearTrail();
+    glutPostRedisplay();
+}
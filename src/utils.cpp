@@ -1,6 +1,6 @@
-#include "utils.h"
-#include "graphics.h"
+#include <algorithm>
 #include <cmath>
+#include "utils.h"
 
 int collectedPoints = 0;
 int drawablePoints = 0;
@@ -10,13 +10,18 @@ const int offsetCircle1Y = 0;
 const int offsetCircle2X = 300;
 const int offsetCircle2Y = 0;
 int circleRadius = 200;
-int worldX, worldY;
+double worldX, worldY;
 double infinityThreshold = 0.05;
 bool isIdealLine[2] = {};
-Matrix3 lineTransformations[2] = {};
-std::tuple<double, bool> lineBaseRotations[2] = {};
+GreatCircle baseLines[2];
 std::tuple<double, double> interactivePoint = {};
 bool canDrawInteractivePoint = false;
+std::tuple<double, double> extraPoints[2][MAX_EXTRA_POINTS] = {};
+int extraPointCount[2] = {};
+uint64_t extraPointsVersion = 0;
+bool extraPointMode = false;
+std::tuple<double, double> extraCandidate = {};
+int extraCandidateLine = -1;
 
 // Dynamic window size tracking
 int currentWindowWidth = INITIAL_WINDOW_WIDTH;
@@ -24,39 +29,6 @@ int currentWindowHeight = INITIAL_WINDOW_HEIGHT;
 bool isFullscreen = false;
 bool showSupportingLines = false;
 
-void myInit(void) {
-    glClearColor(0.0,0.0,0.0,1.0);
-    glPointSize(1.0);
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
-    gluOrtho2D(WORLD_LEFT,WORLD_RIGHT,WORLD_BOTTOM,WORLD_TOP);
-}
-
-void mouseToWorldCoords(int mouseX,int mouseY,int& worldX,int& worldY) {
-    // Dynamic coordinate mapping that exactly matches the shader behavior
-    float worldWidth = WORLD_RIGHT - WORLD_LEFT;   // 1560
-    float worldHeight = WORLD_TOP - WORLD_BOTTOM;  // 840
-    float aspectRatio = (float)currentWindowWidth / currentWindowHeight;
-    float worldAspectRatio = worldWidth / worldHeight;
-    
-    // Convert mouse coords to normalized device coordinates (-1 to 1)
-    float ndcX = (2.0f * mouseX / currentWindowWidth) - 1.0f;
-    float ndcY = 1.0f - (2.0f * mouseY / currentWindowHeight);
-    
-    // Apply inverse of the shader's aspect ratio scaling
-    if(aspectRatio > worldAspectRatio) {
-        // Viewport is wider than world, shader scales X down, so we scale X back up
-        ndcX *= (aspectRatio / worldAspectRatio);
-    } else {
-        // Viewport is taller than world, shader scales Y down, so we scale Y back up
-        ndcY *= (worldAspectRatio / aspectRatio);
-    }
-    
-    // Convert from NDC to world coordinates
-    worldX = (int)(ndcX * (WORLD_RIGHT - WORLD_LEFT) * 0.5f);
-    worldY = (int)(ndcY * (WORLD_TOP - WORLD_BOTTOM) * 0.5f);
-}
-
 double calcNorm2d(double distanceX,double distanceY) {
     return sqrt(pow(distanceX,2)+pow(distanceY,2));
 }
@@ -96,109 +68,21 @@ void getLinePoints(int startIdx, Vector3& p1, Vector3& p2, double radius) {
     p2 = liftToSphere(x2, y2, radius);
 }
 
-// Helper: Draw a projected line on a circle
-void drawProjectedLine(const Matrix3& transformation, float offsetX, float offsetY, float radius, double sinXval, Vector3 linecolor) {
-    Vector3 localCoordPoint, globalCoordPoint;
-    float vx, vy, x, y;
-    std::vector<float> projBuf;
-    std::vector<float> projOppBuf;
-    // subdued gray for supporting lines
-    // draw only the arc from 0..PI (half circle) to avoid drawing the diameter
-    for(float i = 0; i < M_PI; i += 0.001) {
-        localCoordPoint = Vector3(cos(i), sin(i), 0);
-        globalCoordPoint = transformation * localCoordPoint;
-
-        vx = (radius * globalCoordPoint[0]);
-        vy = (radius * globalCoordPoint[1]);
-        x = vx + offsetX;
-        y = vy + offsetY;
-        projBuf.push_back(x);
-        projBuf.push_back(y);
-        projBuf.push_back(linecolor[0]);
-        projBuf.push_back(linecolor[1]);
-        projBuf.push_back(linecolor[2]);
-
-        if(sinXval <= 0.001) {
-            x = -vx + offsetX;
-            y = -vy + offsetY;
-            projOppBuf.push_back(x);
-            projOppBuf.push_back(y);
-            projOppBuf.push_back(linecolor[0]);
-            projOppBuf.push_back(linecolor[1]);
-            projOppBuf.push_back(linecolor[2]);
-        }
+void tessellateEllipse(PackedVertex* out, size_t count, double centerX, double centerY,
+                       double ax, double ay, double bx, double by, double t0, double step, float extent) {
+    // everything in quantization units up front, one rounding per coordinate
+    double scale = QUANTIZATION_MAX / extent;
+    centerX *= scale; centerY *= scale;
+    ax *= scale; ay *= scale;
+    bx *= scale; by *= scale;
+    for(size_t k = 0; k < count; k++) {
+        double t = t0 + k * step;
+        double c = cos(t), s = sin(t);
+        out[k] = {(int16_t)lround(centerX + ax * c + bx * s), (int16_t)lround(centerY + ay * c + by * s)};
     }
-    drawVertices(projBuf, GL_LINE_STRIP);
-    projBuf.clear();
-
-    if(sinXval <= 0.001 && !projOppBuf.empty()) drawVertices(projOppBuf, GL_LINE_STRIP);
-    projOppBuf.clear();
-
 }
 
 Vector3 lineIntersection(const Vector3 &line1, const Vector3 &line2){
     Vector3 cross = line1.cross(line2);
     return cross.normalize()*circleRadius;
 }
-
-void reshapeCallback(int width, int height) {
-    currentWindowWidth = width;
-    currentWindowHeight = height;
-    
-    // Update viewport
-    glViewport(0, 0, width, height);
-    
-    // Update projection matrix for traditional OpenGL calls (if any)
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
-    gluOrtho2D(WORLD_LEFT, WORLD_RIGHT, WORLD_BOTTOM, WORLD_TOP);
-    glMatrixMode(GL_MODELVIEW);
-    
-    glutPostRedisplay();
-}
-
-void keyboardCallback(unsigned char key, int x, int y) {
-    static int savedWindowX = 100, savedWindowY = 100;
-    static int savedWindowWidth = INITIAL_WINDOW_WIDTH;
-    static int savedWindowHeight = INITIAL_WINDOW_HEIGHT;
-    
-    switch(key) {
-        case 'f':
-        case 'F':
-            if(!isFullscreen) {
-                // Save current window position and size
-                savedWindowX = glutGet(GLUT_WINDOW_X);
-                savedWindowY = glutGet(GLUT_WINDOW_Y);
-                savedWindowWidth = glutGet(GLUT_WINDOW_WIDTH);
-                savedWindowHeight = glutGet(GLUT_WINDOW_HEIGHT);
-                
-                // Go fullscreen
-                glutFullScreen();
-                isFullscreen = true;
-            } else {
-                // Exit fullscreen
-                glutReshapeWindow(savedWindowWidth, savedWindowHeight);
-                glutPositionWindow(savedWindowX, savedWindowY);
-                isFullscreen = false;
-            }
-            break;
-        case 27: // ESC key
-            if(isFullscreen) {
-                glutReshapeWindow(savedWindowWidth, savedWindowHeight);
-                glutPositionWindow(savedWindowX, savedWindowY);
-                isFullscreen = false;
-            }
-            break;
-        case 'q':
-        case 'Q':
-            exit(0);
-            break;
-        case 's':
-        case 'S':
-            if(collectedPoints >= 6) {
-                showSupportingLines = !showSupportingLines;
-                glutPostRedisplay();
-            }
-            break;
-    }
-}
\ No newline at end of file
@@ -0,0 +1,232 @@
+#include <GL/glew.h>
+#include <GL/glut.h>
+#include <algorithm>
+#include <cstdlib>
+#include "utils.h"
+#include "graphics.h"
+#include "conics.h"
+#include "pipeline.h"
+#include "allocationCounter.h"
+#include "gallery.h"
+#include "quality.h"
+#include "antialiasing.h"
+#include "capture.h"
+#include "camera.h"
+#include "textOverlay.h"
+#include "trail.h"
+#include "snapping.h"
+#include "drawStream.h"
+#include "iteratedPappus.h"
+#include "hemisphereView.h"
+
+void myInit(void) {
+    glClearColor(0.0,0.0,0.0,1.0);
+    glPointSize(1.0);
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    gluOrtho2D(WORLD_LEFT,WORLD_RIGHT,WORLD_BOTTOM,WORLD_TOP);
+}
+
+void mouseToWorldCoords(int mouseX, int mouseY, double& worldX, double& worldY) {
+    // exact inverse of the camera view the shaders apply
+    screenToWorld(currentView(), mouseX, mouseY, currentWindowWidth, currentWindowHeight, worldX, worldY);
+}
+
+void reshapeCallback(int width, int height) {
+    currentWindowWidth = width;
+    currentWindowHeight = height;
+    
+    // Update viewport
+    glViewport(0, 0, width, height);
+    
+    // Update projection matrix for traditional OpenGL calls (if any)
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    gluOrtho2D(WORLD_LEFT, WORLD_RIGHT, WORLD_BOTTOM, WORLD_TOP);
+    glMatrixMode(GL_MODELVIEW);
+
+    // culling and the background layer depend on the visible rectangle
+    publishInput();
+    glutPostRedisplay();
+}
+
+void keyboardCallback(unsigned char key, int x, int y) {
+    static int savedWindowX = 100, savedWindowY = 100;
+    static int savedWindowWidth = INITIAL_WINDOW_WIDTH;
+    static int savedWindowHeight = INITIAL_WINDOW_HEIGHT;
+    
+    switch(key) {
+        case 'f':
+        case 'F':
+            if(!isFullscreen) {
+                // Save current window position and size
+                savedWindowX = glutGet(GLUT_WINDOW_X);
+                savedWindowY = glutGet(GLUT_WINDOW_Y);
+                savedWindowWidth = glutGet(GLUT_WINDOW_WIDTH);
+                savedWindowHeight = glutGet(GLUT_WINDOW_HEIGHT);
+                
+                // Go fullscreen
+                glutFullScreen();
+                isFullscreen = true;
+            } else {
+                // Exit fullscreen
+                glutReshapeWindow(savedWindowWidth, savedWindowHeight);
+                glutPositionWindow(savedWindowX, savedWindowY);
+                isFullscreen = false;
+            }
+            break;
+        case 27: // ESC key
+            if(isFullscreen) {
+                glutReshapeWindow(savedWindowWidth, savedWindowHeight);
+                glutPositionWindow(savedWindowX, savedWindowY);
+                isFullscreen = false;
+            }
+            break;
+        case 'q':
+        case 'Q':
+            stopCapture();
+            stopDrawStream();
+            exit(0);
+            break;
+        case 's':
+        case 'S':
+            if(collectedPoints >= 6) {
+                showSupportingLines = !showSupportingLines;
+                publishInput();
+            }
+            break;
+        case 'm':
+        case 'M':
+            showAllocationStats = !showAllocationStats;
+            publishInput();
+            break;
+        case 'c':
+        case 'C':
+            useAnalyticConics = !useAnalyticConics;
+            publishInput();
+            break;
+        case 'p':
+        case 'P':
+            progressiveQuality = !progressiveQuality;
+            publishInput();
+            break;
+        case 'g':
+        case 'G':
+            galleryMode = !galleryMode;
+            glutPostRedisplay();
+            break;
+        case '+':
+        case '=':
+            if(galleryMode) {
+                setGallerySize(gallerySize() * 2);
+                glutPostRedisplay();
+            }
+            else {
+                zoomCameraAt(currentWindowWidth / 2, currentWindowHeight / 2, CAMERA_ZOOM_STEP);
+            }
+            break;
+        case '-':
+            if(galleryMode) {
+                setGallerySize(gallerySize() / 2);
+                glutPostRedisplay();
+            }
+            else {
+                zoomCameraAt(currentWindowWidth / 2, currentWindowHeight / 2, 1.0 / CAMERA_ZOOM_STEP);
+            }
+            break;
+        case 'b':
+        case 'B':
+            startGallerySweep();
+            break;
+        case 'a':
+        case 'A':
+            cycleAntialiasingMode();
+            glutPostRedisplay();
+            break;
+        case 'r':
+        case 'R':
+            toggleCapture();
+            glutPostRedisplay();
+            break;
+        case 'w':
+        case 'W':
+            startCaptureSweep(CAPTURE_SWEEP_STEPS);
+            break;
+        case '0':
+            resetCamera();
+            break;
+        case 'e':
+        case 'E':
+            toggleExtraPointMode();
+            break;
+        case 'n':
+        case 'N':
+            generateExtraPoints();
+            break;
+        case 'h':
+        case 'H':
+            showTextOverlay = !showTextOverlay;
+            glutPostRedisplay();
+            break;
+        case 't':
+        case 'T':
+            toggleTrail();
+            break;
+        case 'k':
+        case 'K':
+            toggleSnapping();
+            break;
+        case 'd':
+        case 'D':
+            toggleDrawStream();
+            glutPostRedisplay();
+            break;
+        case 'i':
+        case 'I':
+            toggleIteratedPappus();
+            break;
+        case 'v':
+        case 'V':
+            toggleHemisphereView();
+            break;
+    }
+}
+
+void specialKeyCallback(int key, int x, int y) {
+    // arrows move the view by a tenth of the window
+    int stepX = currentWindowWidth / 10, stepY = currentWindowHeight / 10;
+    switch(key) {
+        case GLUT_KEY_LEFT:  panCamera(stepX, 0);  break;
+        case GLUT_KEY_RIGHT: panCamera(-stepX, 0); break;
+        case GLUT_KEY_UP:    panCamera(0, stepY);  break;
+        case GLUT_KEY_DOWN:  panCamera(0, -stepY); break;
+    }
+}
+
+// the scene depends on the view (culling, tessellation step), the gallery just redraws
+static void cameraChanged() {
+    publishInput();
+    glutPostRedisplay();
+}
+
+void zoomCameraAt(int mouseX, int mouseY, double factor) {
+    double beforeX, beforeY, afterX, afterY;
+    screenToWorld(currentView(), mouseX, mouseY, currentWindowWidth, currentWindowHeight, beforeX, beforeY);
+    camera.zoom = std::clamp(camera.zoom * factor, MIN_CAMERA_ZOOM, MAX_CAMERA_ZOOM);
+    screenToWorld(currentView(), mouseX, mouseY, currentWindowWidth, currentWindowHeight, afterX, afterY);
+    camera.centerX += beforeX - afterX;
+    camera.centerY += beforeY - afterY;
+    cameraChanged();
+}
+
+void panCamera(int dx, int dy) {
+    ViewTransform view = currentView();
+    camera.centerX -= dx * view.pixelSize;
+    camera.centerY += dy * view.pixelSize;
+    cameraChanged();
+}
+
+void resetCamera() {
+    camera = Camera();
+    cameraChanged();
+}
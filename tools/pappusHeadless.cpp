@@ -0,0 +1,17 @@
+// Modos sem janela num executável sem nenhuma dependência do GL: servidor de cálculo, datasets
+// e renderização pelo rasterizador em CPU. Same options as ./app --serve / --pack / --compute / --render.
+//
+//   g++ -std=c++17 -O2 -pthread -Iinclude tools/pappusHeadless.cpp src/headless.cpp src/computeServer.cpp
+//       src/Dataset.cpp src/pappus.cpp src/cpuRasterizer.cpp src/pngWriter.cpp src/scene.cpp
+//       src/FrameGeometry.cpp src/FrameArena.cpp src/ConicSet.cpp src/renderBackend.cpp src/camera.cpp
+//       src/utils.cpp src/GreatCircle.cpp src/Vector3.cpp src/Matrix3.cpp src/TaskPool.cpp -o pappusHeadless
+//   echo "50 30 -80 60 10 20 40 -70 -20 90 0 0 120 -40" | ./pappusHeadless --render cena.png 1920 1080
+#include <cstdio>
+#include "computeServer.h"
+
+int main(int argc, char** argv) {
+    int status = runHeadlessCommand(argc, argv);
+    if(status >= 0) return status;
+    fprintf(stderr, "usage: %s --serve | --pack <dataset> | --compute <in> <out> [shard/count] | --render <png> [width height]\n", argv[0]);
+    return 1;
+}
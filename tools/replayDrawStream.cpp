@@ -0,0 +1,337 @@
+// Reenvio de um fluxo de desenho gravado com a tecla D, o mais rápido possível, a um alvo fora
+// da tela do tamanho da janela gravada; mede o envio na CPU e o tempo na GPU, sem a construção.
+//
+//   g++ -std=c++17 -O2 tools/replayDrawStream.cpp -Iinclude -o replayDrawStream -lGLEW -lGL -lglut
+//   ./replayDrawStream pappus-draws.pds [passes]
+//
+// The whole file is loaded and parsed up front; a pass re-issues every frame, uploading and
+// drawing exactly like the GL backend of the application (same shader, buffers and state).
+#include <GL/glew.h>
+#include <GL/glut.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "drawStream.h"
+#include "sceneShaders.h"
+
+// one recorded call, pointing into the loaded file
+struct ReplayDraw {
+    DrawStreamRecord kind;
+    GLenum mode;               // vertices only
+    const float* view;
+    const float* origin;       // vertices only
+    const void* vertices;
+    size_t vertexCount;
+    const GLuint* indices;     // packed only
+    size_t indexCount;
+    const DrawStreamBatch* batches;
+    size_t batchCount;
+};
+
+struct ReplayFrame {
+    std::vector<ReplayDraw> draws;
+};
+
+static GLuint program = 0, packedVao = 0, interleavedVao = 0, vbo = 0, ibo = 0;
+static size_t vboCapacityBytes = 0, iboCapacityBytes = 0;
+static GLint uni_uView = -1, uni_uOrigin = -1, uni_uPositionScale = -1, uni_uIsPoint = -1;
+
+// per pass totals
+static size_t drawCalls = 0, uploadedBytes = 0, uploadedVertices = 0;
+
+static GLuint compileShader(GLenum type, const char* src) {
+    GLuint s = glCreateShader(type);
+    glShaderSource(s, 1, &src, nullptr);
+    glCompileShader(s);
+    GLint ok;
+    glGetShaderiv(s, GL_COMPILE_STATUS, &ok);
+    if(!ok) {
+        char buf[1024];
+        glGetShaderInfoLog(s, 1024, nullptr, buf);
+        fprintf(stderr, "Shader compile error: %s\n", buf);
+    }
+    return s;
+}
+
+static void initReplayResources() {
+    GLuint vs = compileShader(GL_VERTEX_SHADER, vertexShaderSrc);
+    GLuint fs = compileShader(GL_FRAGMENT_SHADER, fragmentShaderSrc);
+    program = glCreateProgram();
+    glAttachShader(program, vs);
+    glAttachShader(program, fs);
+    glLinkProgram(program);
+    glDeleteShader(vs);
+    glDeleteShader(fs);
+    glUseProgram(program);
+    uni_uView = glGetUniformLocation(program, "uView");
+    uni_uOrigin = glGetUniformLocation(program, "uOrigin");
+    uni_uPositionScale = glGetUniformLocation(program, "uPositionScale");
+    uni_uIsPoint = glGetUniformLocation(program, "uIsPoint");
+    GLint uni_uAlpha = glGetUniformLocation(program, "uAlpha");
+    GLint uni_uPointSize = glGetUniformLocation(program, "uPointSize");
+    if(uni_uAlpha != -1) glUniform1f(uni_uAlpha, 1.0f);
+    if(uni_uPointSize != -1) glUniform1f(uni_uPointSize, 6.0f);
+    glUseProgram(0);
+
+    glGenBuffers(1, &vbo);
+    glGenBuffers(1, &ibo);
+    glGenVertexArrays(1, &packedVao);
+    glBindVertexArray(packedVao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+    vboCapacityBytes = 1024 * 1024;
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)vboCapacityBytes, nullptr, GL_STREAM_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_SHORT, GL_FALSE, 2 * sizeof(GLshort), (void*)0);
+    glDisableVertexAttribArray(1);
+
+    glGenVertexArrays(1, &interleavedVao);
+    glBindVertexArray(interleavedVao);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 5, (void*)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 5, (void*)(sizeof(float) * 2));
+    glBindVertexArray(0);
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glHint(GL_LINE_SMOOTH_HINT, GL_NICEST);
+    glEnable(GL_LINE_SMOOTH);
+    glEnable(GL_PRIMITIVE_RESTART);
+    glPrimitiveRestartIndex(DRAW_STREAM_RESTART_INDEX);
+}
+
+static void ensureVboCapacity(size_t bytes) {
+    if(bytes <= vboCapacityBytes) return;
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)bytes, nullptr, GL_STREAM_DRAW);
+    vboCapacityBytes = bytes;
+}
+
+static void setPrimitive(GLenum mode) {
+    if(uni_uIsPoint != -1) glUniform1i(uni_uIsPoint, mode == GL_POINTS ? 1 : 0);
+}
+
+static void issue(const ReplayDraw& draw) {
+    if(uni_uView != -1) glUniformMatrix3fv(uni_uView, 1, GL_FALSE, draw.view);
+    if(draw.kind == DRAW_STREAM_VERTICES) {
+        glBindVertexArray(interleavedVao);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        size_t bytes = draw.vertexCount * 5 * sizeof(float);
+        ensureVboCapacity(bytes);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)bytes, draw.vertices);
+        setPrimitive(draw.mode);
+        if(uni_uOrigin != -1) glUniform2fv(uni_uOrigin, 1, draw.origin);
+        if(uni_uPositionScale != -1) glUniform1f(uni_uPositionScale, 1.0f);
+        glDrawArrays(draw.mode, 0, (GLsizei)draw.vertexCount);
+        drawCalls++;
+        uploadedBytes += bytes;
+        uploadedVertices += draw.vertexCount;
+        return;
+    }
+    glBindVertexArray(packedVao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    size_t bytes = draw.vertexCount * 2 * sizeof(GLshort);
+    ensureVboCapacity(bytes);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)bytes, draw.vertices);
+    size_t indexBytes = draw.indexCount * sizeof(GLuint);
+    if(indexBytes > iboCapacityBytes) {
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)indexBytes, draw.indices, GL_STREAM_DRAW);
+        iboCapacityBytes = indexBytes;
+    }
+    else {
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, (GLsizeiptr)indexBytes, draw.indices);
+    }
+    for(size_t b = 0; b < draw.batchCount; b++) {
+        const DrawStreamBatch& batch = draw.batches[b];
+        setPrimitive(batch.mode);
+        if(uni_uOrigin != -1) glUniform2fv(uni_uOrigin, 1, batch.origin);
+        if(uni_uPositionScale != -1) glUniform1f(uni_uPositionScale, batch.positionScale);
+        glVertexAttrib3fv(1, batch.color);
+        glDrawElements(batch.mode, (GLsizei)batch.indexCount, GL_UNSIGNED_INT, (void*)(batch.firstIndex * sizeof(GLuint)));
+    }
+    drawCalls += draw.batchCount;
+    uploadedBytes += bytes + indexBytes;
+    uploadedVertices += draw.vertexCount;
+}
+
+// sequential reader over the loaded file; every take fails once the data runs out
+class StreamReader {
+public:
+    StreamReader(const std::vector<unsigned char>& data) : data(data) {}
+    bool atEnd() const { return offset == data.size(); }
+    const void* take(size_t bytes) {
+        if(bytes > data.size() - offset) return nullptr;
+        const void* p = data.data() + offset;
+        offset += bytes;
+        return p;
+    }
+    bool takeU32(uint32_t& value) {
+        const void* p = take(sizeof value);
+        if(p) memcpy(&value, p, sizeof value);
+        return p != nullptr;
+    }
+
+private:
+    const std::vector<unsigned char>& data;
+    size_t offset = 0;
+};
+
+static bool parseStream(const std::vector<unsigned char>& data, DrawStreamHeader& header, std::vector<ReplayFrame>& frames) {
+    StreamReader reader(data);
+    const void* h = reader.take(sizeof header);
+    if(!h) return false;
+    memcpy(&header, h, sizeof header);
+    if(header.magic != DRAW_STREAM_MAGIC || header.version != DRAW_STREAM_VERSION) return false;
+    while(!reader.atEnd()) {
+        uint32_t kind;
+        if(!reader.takeU32(kind)) return false;
+        if(kind == DRAW_STREAM_FRAME) {
+            uint32_t number;
+            if(!reader.takeU32(number)) return false;
+            frames.emplace_back();
+            continue;
+        }
+        // draws before the first frame marker get a frame of their own
+        if(frames.empty()) frames.emplace_back();
+        ReplayDraw draw = {};
+        draw.kind = (DrawStreamRecord)kind;
+        if(kind == DRAW_STREAM_VERTICES) {
+            uint32_t mode, floatCount;
+            if(!reader.takeU32(mode)) return false;
+            draw.mode = mode;
+            draw.view = (const float*)reader.take(9 * sizeof(float));
+            draw.origin = (const float*)reader.take(2 * sizeof(float));
+            if(!draw.view || !draw.origin || !reader.takeU32(floatCount)) return false;
+            draw.vertexCount = floatCount / 5;
+            draw.vertices = reader.take((size_t)floatCount * sizeof(float));
+            if(!draw.vertices) return false;
+        }
+        else if(kind == DRAW_STREAM_PACKED) {
+            uint32_t vertexCount, indexCount, batchCount;
+            draw.view = (const float*)reader.take(9 * sizeof(float));
+            if(!draw.view || !reader.takeU32(vertexCount) || !reader.takeU32(indexCount) || !reader.takeU32(batchCount)) return false;
+            draw.vertexCount = vertexCount;
+            draw.indexCount = indexCount;
+            draw.batchCount = batchCount;
+            draw.vertices = reader.take((size_t)vertexCount * 2 * sizeof(GLshort));
+            draw.indices = (const GLuint*)reader.take((size_t)indexCount * sizeof(GLuint));
+            draw.batches = (const DrawStreamBatch*)reader.take((size_t)batchCount * sizeof(DrawStreamBatch));
+            if(!draw.vertices || !draw.indices || !draw.batches) return false;
+        }
+        else {
+            return false;
+        }
+        frames.back().draws.push_back(draw);
+    }
+    return true;
+}
+
+static bool loadFile(const char* path, std::vector<unsigned char>& data) {
+    FILE* file = fopen(path, "rb");
+    if(!file) return false;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    data.resize(size > 0 ? (size_t)size : 0);
+    bool ok = fread(data.data(), 1, data.size(), file) == data.size();
+    fclose(file);
+    return ok;
+}
+
+static double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+    if(argc < 2) {
+        fprintf(stderr, "usage: %s <stream.pds> [passes]\n", argv[0]);
+        return 1;
+    }
+    int passes = argc > 2 ? atoi(argv[2]) : 10;
+    if(passes < 1) passes = 1;
+
+    std::vector<unsigned char> data;
+    if(!loadFile(argv[1], data)) {
+        fprintf(stderr, "Cannot read %s\n", argv[1]);
+        return 1;
+    }
+    DrawStreamHeader header;
+    std::vector<ReplayFrame> frames;
+    if(!parseStream(data, header, frames)) {
+        fprintf(stderr, "%s is not a valid draw stream\n", argv[1]);
+        return 1;
+    }
+
+    // the window only provides the context; everything is drawn into the framebuffer below
+    glutInit(&argc, argv);
+    glutInitDisplayMode(GLUT_SINGLE | GLUT_RGB);
+    glutInitWindowSize(64, 64);
+    glutCreateWindow("replayDrawStream");
+    glutHideWindow();
+    glewExperimental = GL_TRUE;
+    if(glewInit() != GLEW_OK) {
+        fprintf(stderr, "glewInit failed\n");
+        return 1;
+    }
+    int width = (int)header.width, height = (int)header.height;
+    GLuint fbo, colorBuffer;
+    glGenFramebuffers(1, &fbo);
+    glGenRenderbuffers(1, &colorBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+    if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        fprintf(stderr, "Cannot create a %dx%d offscreen target\n", width, height);
+        return 1;
+    }
+    glViewport(0, 0, width, height);
+    initReplayResources();
+
+    auto replayPass = [&]() {
+        drawCalls = uploadedBytes = uploadedVertices = 0;
+        glUseProgram(program);
+        for(const ReplayFrame& frame : frames) {
+            glClear(GL_COLOR_BUFFER_BIT);
+            for(const ReplayDraw& draw : frame.draws) issue(draw);
+        }
+        glBindVertexArray(0);
+        glUseProgram(0);
+    };
+    // warm up driver allocations and shader variants
+    replayPass();
+    glFinish();
+
+    GLuint query;
+    glGenQueries(1, &query);
+    double submitMs = 0.0, gpuMs = 0.0, wallMs = 0.0;
+    for(int p = 0; p < passes; p++) {
+        auto start = std::chrono::steady_clock::now();
+        glBeginQuery(GL_TIME_ELAPSED, query);
+        replayPass();
+        glEndQuery(GL_TIME_ELAPSED);
+        submitMs += elapsedMs(start);
+        glFinish();
+        wallMs += elapsedMs(start);
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &ns);
+        gpuMs += ns / 1e6;
+    }
+    glDeleteQueries(1, &query);
+
+    double frameCount = (double)frames.size() * passes;
+    printf("draw stream %s: %dx%d, %zu frames, %zu draws, %zu vertices and %.2f MB uploaded per pass, %d passes\n",
+           argv[1], width, height, frames.size(), drawCalls, uploadedVertices, uploadedBytes / (1024.0 * 1024.0), passes);
+    printf("  submission: %.3f ms/frame, %.0f draws/s, %.1f M vertices/s\n", submitMs / frameCount,
+           drawCalls * passes / (submitMs / 1000.0), uploadedVertices * passes / (submitMs * 1000.0));
+    printf("  gpu:        %.3f ms/frame, %.1f M vertices/s\n", gpuMs / frameCount,
+           uploadedVertices * passes / (gpuMs * 1000.0));
+    printf("  wall:       %.3f ms/frame, %.1f frames/s\n", wallMs / frameCount, frameCount / (wallMs / 1000.0));
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteRenderbuffers(1, &colorBuffer);
+    glDeleteFramebuffers(1, &fbo);
+    return 0;
+}